@@ -14,27 +14,54 @@ void Fuzz<SampleType>::prepare(juce::dsp::ProcessSpec& spec)
 {
 
     _sampleRate = spec.sampleRate;
+    _tileLength = juce::jmin(static_cast<size_t>(spec.maximumBlockSize), _tileSize);
 
-    //dc offset highpass filter
-    _dcFilter.prepare(spec);
-    _dcFilter.setCutoffFrequency(10.0);
-    _dcFilter.setType(juce::dsp::LinkwitzRileyFilter<float>::Type::highpass);
+    //Block engine scratch memory (one tile, so it stays in cache whatever the host's block size)
+    _inputGain.allocate(_tileLength);
+    _outputGain.allocate(_tileLength);
+    _mixWeights.allocate(_tileLength);
+
+    _dryBlock = juce::dsp::AudioBlock<SampleType>(_dryMemory, spec.numChannels, _tileLength);
+    _wetBlock = juce::dsp::AudioBlock<SampleType>(_wetMemory, spec.numChannels, _tileLength);
+    _crossfadeBlock = juce::dsp::AudioBlock<SampleType>(_crossfadeMemory, 1, _tileLength << _maxOversamplingFactor);
+
+    //ADAA history
+    _antiderivativeStates.resize(spec.numChannels);
 
-    // Prepare low-pass filter
-    _lowPassFilter.prepare(spec);
-    _lowPassFilter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
-    _lowPassFilter.setCutoffFrequency(_lowPassCutoff); // Default cutoff frequency
+    //Lookup table shaper (built here, off the audio thread, the first time this resolution is used)
+    _waveshaperTables = &getWaveshaperTables(_shaperTableSize);
 
+    //Oversampling (every factor and filter type is built here so switching never allocates)
+    _oversamplers.clear();
+    int maxLatency = 0;
 
-    //Tone
-    // Prepare low-pass filter
-    _toneLowPassFilter.prepare(spec);
-    _toneLowPassFilter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    for (int factor = 1; factor <= _maxOversamplingFactor; ++factor)
+    {
+        for (auto filterType : { juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+                                 juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple })
+        {
+            auto* oversampler = _oversamplers.add(new juce::dsp::Oversampling<SampleType>(spec.numChannels,
+                static_cast<size_t>(factor), filterType, true, true));
+
+            oversampler->initProcessing(_tileLength);
+            maxLatency = juce::jmax(maxLatency, juce::roundToInt(oversampler->getLatencyInSamples()));
+        }
+    }
+
+    _oversampler = nullptr;
+    _oversamplerIndex = getOversamplerIndex();
+    _activeOversamplerIndex = -1;
+
+    _dryDelay.setMaximumDelayInSamples(juce::jmax(1, maxLatency));
+    _dryDelay.prepare(spec);
+
+    //dc offset highpass filter
+    _dcBlocker.prepare(spec.sampleRate, _tileLength, spec.numChannels);
 
-    // Prepare high-pass filter for tone control (high frequencies)
-    _toneHighPassFilter.prepare(spec);
-    _toneHighPassFilter.setType(juce::dsp::StateVariableTPTFilterType::highpass);
-    //TONE
+    //Tone (every setting's coefficients for this sample rate, shared with other instances)
+    _toneTable = &getToneTable(spec.sampleRate);
+    _toneFilter.prepare(_tileLength, spec.numChannels, juce::roundToInt(_toneRampSeconds * spec.sampleRate));
+    _toneFilter.setTarget(getToneSetting(_toneChar, _toneSweep.getTargetValue()), 0);
 
     reset();
 }
@@ -53,11 +80,36 @@ void Fuzz<SampleType>::reset()
     _output.reset(_sampleRate, 0.02);
     _output.setTargetValue(0.0);
 
-    // Reset dcFilter
-    _dcFilter.reset();
+    _toneSweep.reset(_sampleRate, 0.02);
+    _toneSweep.setTargetValue(0.0);
 
-    // Reset low pass filter
-    _lowPassFilter.reset();
+    _activeModel = _model;
+    _activeShaperMode = _shaperMode;
+
+    _numSilentSamples = 0;
+    _isSkippingSilence = false;
+
+    clearProcessingState();
+    updateTailLength();
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::clearProcessingState() noexcept
+{
+    // Reset ADAA history
+    std::fill(_antiderivativeStates.begin(), _antiderivativeStates.end(), AntiderivativeState{});
+
+    // Reset oversampling
+    for (auto* oversampler : _oversamplers)
+        oversampler->reset();
+
+    _dryDelay.reset();
+
+    // Reset dcFilter (blocking only for the model that generates DC)
+    _dcBlocker.clear(_model == FuzzModel::kHard);
+
+    // Reset tone filters
+    _toneFilter.clear();
 }
 template <typename SampleType>
 void Fuzz<SampleType>::setDrive(SampleType newDrive)
@@ -104,60 +156,245 @@ void Fuzz<SampleType>::setFuzzModel(FuzzModel newModel)
 }
 
 template <typename SampleType>
-void Fuzz<SampleType>::setToneCharacter(ToneCharacter newToneChar)
+void Fuzz<SampleType>::setShaperMode(ShaperMode newMode)
 {
-    float darkerFreq = 2500.0f; //First LowPass Stage
-    float darkestFreq = 900.0f; //Second LowPass Stage
-    float brighterFreq = 200.0f; //First HighPass Stage
-    float brightestFreq = 400.0f; //Second HighPass Stage
+    _shaperMode = newMode;
+}
 
-    switch (newToneChar)
-    {
-    case ToneCharacter::darkest:
-    {
-        _toneChar = newToneChar;
+template <typename SampleType>
+void Fuzz<SampleType>::setStageBypassed(Stage stage, bool shouldBeBypassed)
+{
+    auto& isBypassed = stage == Stage::dcBlocker ? _isDcBlockerBypassed : _isToneBypassed;
 
-        _toneLowPassFilter.setCutoffFrequency(darkestFreq);
-        _toneHighPassFilter.setCutoffFrequency(10.0f);
-        break;
-    }
+    if (isBypassed == shouldBeBypassed)
+        return;
 
-    case ToneCharacter::darker:
-    {
-        _toneChar = newToneChar;
+    isBypassed = shouldBeBypassed;
 
-        _toneLowPassFilter.setCutoffFrequency(darkerFreq);
-        _toneHighPassFilter.setCutoffFrequency(10.0f);
-        break;
-    }
+    //A stage coming back starts from a clean state rather than whatever it held when it was bypassed
+    if (stage == Stage::dcBlocker)
+        _dcBlocker.clear(_model == FuzzModel::kHard);
+    else
+        _toneFilter.clear();
+
+    updateTailLength();
+}
 
-    case ToneCharacter::normal:
+template <typename SampleType>
+bool Fuzz<SampleType>::isStageBypassed(Stage stage) const noexcept
+{
+    return stage == Stage::dcBlocker ? _isDcBlockerBypassed : _isToneBypassed;
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::setOversampling(int newFactor, OversamplingFilter newFilter)
+{
+    _oversamplingFactor = juce::jlimit(0, _maxOversamplingFactor, newFactor);
+    _oversamplingFilter = newFilter;
+    _oversamplerIndex = getOversamplerIndex();
+
+    updateTailLength();
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::setShaperTableSize(size_t newNumPoints)
+{
+    _shaperTableSize = juce::jmax(static_cast<size_t>(2), newNumPoints);
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::setTileSize(size_t newTileSize)
+{
+    _tileSize = juce::jmax(static_cast<size_t>(1), newTileSize);
+}
+
+template <typename SampleType>
+typename Fuzz<SampleType>::ShaperTableAccuracy Fuzz<SampleType>::measureShaperTableAccuracy(size_t numPoints)
+{
+    const auto& tables = getWaveshaperTables(juce::jmax(static_cast<size_t>(2), numPoints));
+
+    //Sweeps the driven signal past both knees, far finer than any table
+    constexpr int numSteps = 1 << 16;
+    constexpr double range = 2.0;
+
+    ShaperTableAccuracy accuracy;
+
+    for (int i = 0; i <= numSteps; ++i)
     {
-        _toneChar = newToneChar;
-        
-        _toneLowPassFilter.setCutoffFrequency(13000.0f);
-        _toneHighPassFilter.setCutoffFrequency(10.0f); 
-        break;
+        const auto drivenSample = static_cast<SampleType>(-range + 2.0 * range * i / numSteps);
+
+        accuracy.hard = juce::jmax(accuracy.hard,
+            std::abs(tables.template transfer<FuzzModel::kHard>(drivenSample) - shapeSample<FuzzModel::kHard>(drivenSample)));
+        accuracy.redux = juce::jmax(accuracy.redux,
+            std::abs(tables.template transfer<FuzzModel::kRedux>(drivenSample) - shapeSample<FuzzModel::kRedux>(drivenSample)));
+        accuracy.fat = juce::jmax(accuracy.fat,
+            std::abs(tables.template transfer<FuzzModel::kFat>(drivenSample) - shapeSample<FuzzModel::kFat>(drivenSample)));
     }
 
-    case ToneCharacter::brighter:
-    {
-        _toneChar = newToneChar;
+    return accuracy;
+}
 
-        _toneHighPassFilter.setCutoffFrequency(brighterFreq);
-        _toneLowPassFilter.setCutoffFrequency(20000.0f);
-        break;
+template <typename SampleType>
+int Fuzz<SampleType>::getLatencyInSamples() const noexcept
+{
+    return getLatencyInSamples(_oversamplingFactor, _oversamplingFilter);
+}
+
+//Only reads the oversamplers built in prepare(), so any thread can ask for the latency of a setting
+template <typename SampleType>
+int Fuzz<SampleType>::getLatencyInSamples(int factor, OversamplingFilter filter) const noexcept
+{
+    const auto index = getOversamplerIndex(juce::jlimit(0, _maxOversamplingFactor, factor), filter);
+
+    if (index < 0)
+        return 0;
+
+    return juce::roundToInt(_oversamplers.getUnchecked(index)->getLatencyInSamples());
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::updateTailLength() noexcept
+{
+    //The tone filters are Butterworth pole pairs (damping 1/sqrt2), so the lowest cutoff decays slowest,
+    //with a time constant of 1 / (damping * 2 pi fc). The DC blocker is one real pole, 1 / (2 pi fc)
+    //Bypassed stages do not ring. A moving sweep is counted at its target
+    auto timeConstant = 0.0;
+
+    if (! _isDcBlockerBypassed)
+        timeConstant = 1.0 / (juce::MathConstants<double>::twoPi * _dcBlockerCutoff);
+
+    if (! _isToneBypassed && _toneTable != nullptr)
+    {
+        const auto setting = getToneSetting(_toneChar, _toneSweep.getTargetValue());
+        const auto lowestToneCutoff = juce::jmin(setting.highPassCutoff, setting.lowPassCutoff);
+        timeConstant = juce::jmax(timeConstant, juce::MathConstants<double>::sqrt2 / (juce::MathConstants<double>::twoPi * lowestToneCutoff));
     }
 
-    case ToneCharacter::brightest:
+    const auto seconds = _tailTimeConstants * timeConstant + getLatencyInSamples() / static_cast<double>(_sampleRate);
+
+    _tailLengthInSamples = static_cast<juce::int64>(std::ceil(seconds * _sampleRate));
+    _tailLengthSeconds.store(seconds, std::memory_order_relaxed);
+}
+
+template <typename SampleType>
+int Fuzz<SampleType>::getOversamplerIndex() const noexcept
+{
+    return getOversamplerIndex(_oversamplingFactor, _oversamplingFilter);
+}
+
+template <typename SampleType>
+int Fuzz<SampleType>::getOversamplerIndex(int factor, OversamplingFilter filter) const noexcept
+{
+    if (factor == 0 || _oversamplers.isEmpty())
+        return -1;
+
+    return (factor - 1) * 2 + (filter == OversamplingFilter::polyphaseIIR ? 0 : 1);
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::switchOversampler() noexcept
+{
+    const auto index = _oversamplerIndex;
+
+    //The new oversampler and the dry delay start from silence
+    _activeOversamplerIndex = index;
+    _oversampler = index < 0 ? nullptr : _oversamplers.getUnchecked(index);
+
+    if (_oversampler != nullptr)
+        _oversampler->reset();
+
+    _dryDelay.reset();
+    _dryDelay.setDelay(static_cast<SampleType>(getLatencyInSamples()));
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::setToneCharacter(ToneCharacter newToneChar)
+{
+    _toneChar = newToneChar;
+
+    //Before prepare() there is no table yet, prepare() picks up _toneChar
+    if (_toneTable != nullptr)
+        _toneFilter.setTarget(getToneSetting(newToneChar, _toneSweep.getTargetValue()), _toneFilter.rampLength);
+
+    updateTailLength();
+}
+
+template <typename SampleType>
+void Fuzz<SampleType>::setToneSweep(SampleType newSweep)
+{
+    _toneSweep.setTargetValue(static_cast<float>(juce::jlimit(static_cast<SampleType>(-1), static_cast<SampleType>(1), newSweep)));
+
+    updateTailLength();
+}
+
+template <typename SampleType>
+typename Fuzz<SampleType>::ToneSetting Fuzz<SampleType>::getToneSetting(ToneCharacter toneChar, float sweep) const noexcept
+{
+    const auto& preset = (*_toneTable)[static_cast<size_t>(toneChar)];
+
+    if (sweep == 0.0f)
+        return preset;
+
+    //Negative sweeps darken (low-pass down), positive sweeps brighten (high-pass up)
+    const auto sampleRate = static_cast<double>(_sampleRate);
+    const auto lowPassCutoff = juce::jlimit(10.0, sampleRate * 0.49, preset.lowPassCutoff * std::exp2(juce::jmin(sweep, 0.0f) * _toneSweepOctaves));
+    const auto highPassCutoff = juce::jlimit(10.0, sampleRate * 0.49, preset.highPassCutoff * std::exp2(juce::jmax(sweep, 0.0f) * _toneSweepOctaves));
+
+    //Pade approximant below _fastTanLimit of the sample rate, within 3e-7 (float) and 4e-10 (double) of std::tan relative
+    //Its error grows quickly towards Nyquist (8e-5 absolute in float at 0.49), so cutoffs above the limit use std::tan
+    //like the preset table, and a sweep just off 0 lands on the preset's coefficients
+    auto makeCoefficients = [sampleRate](double cutoff)
     {
-        _toneChar = newToneChar;
+        const auto warped = juce::MathConstants<double>::pi * cutoff / sampleRate;
 
-        _toneHighPassFilter.setCutoffFrequency(brightestFreq);
-        _toneLowPassFilter.setCutoffFrequency(20000.0f);
-        break;
-    }
-    }
+        if (cutoff > sampleRate * _fastTanLimit)
+            return ToneFilterBank::getCoefficients(static_cast<SampleType>(std::tan(warped)));
+
+        return ToneFilterBank::getCoefficients(juce::dsp::FastMathApproximations::tan(static_cast<SampleType>(warped)));
+    };
+
+    return { lowPassCutoff, highPassCutoff, makeCoefficients(lowPassCutoff), makeCoefficients(highPassCutoff) };
+}
+
+template <typename SampleType>
+const typename Fuzz<SampleType>::ToneTable& Fuzz<SampleType>::getToneTable(double sampleRate)
+{
+    static juce::CriticalSection lock;
+    static std::map<double, std::unique_ptr<ToneTable>> tables;
+
+    const juce::ScopedLock sl(lock);
+    auto& entry = tables[sampleRate];
+
+    if (entry != nullptr)
+        return *entry;
+
+    float darkerFreq = 2500.0f; //First LowPass Stage
+    float darkestFreq = 900.0f; //Second LowPass Stage
+    float brighterFreq = 200.0f; //First HighPass Stage
+    float brightestFreq = 400.0f; //Second HighPass Stage
+
+    auto makeSetting = [sampleRate](double lowPassCutoff, double highPassCutoff)
+    {
+        //Cutoffs above Nyquist (low sample rates) are held just below it
+        auto makeCoefficients = [sampleRate](double cutoff)
+        {
+            const auto g = std::tan(juce::MathConstants<double>::pi * juce::jmin(cutoff, sampleRate * 0.49) / sampleRate);
+            return ToneFilterBank::getCoefficients(static_cast<SampleType>(g));
+        };
+
+        return ToneSetting{ lowPassCutoff, highPassCutoff, makeCoefficients(lowPassCutoff), makeCoefficients(highPassCutoff) };
+    };
+
+    entry = std::make_unique<ToneTable>();
+    auto& table = *entry;
+
+    table[static_cast<size_t>(ToneCharacter::darkest)]   = makeSetting(darkestFreq, 10.0);
+    table[static_cast<size_t>(ToneCharacter::darker)]    = makeSetting(darkerFreq, 10.0);
+    table[static_cast<size_t>(ToneCharacter::normal)]    = makeSetting(13000.0, 10.0);
+    table[static_cast<size_t>(ToneCharacter::brighter)]  = makeSetting(20000.0, brighterFreq);
+    table[static_cast<size_t>(ToneCharacter::brightest)] = makeSetting(20000.0, brightestFreq);
+
+    return table;
 }
 
 template class Fuzz<float>;
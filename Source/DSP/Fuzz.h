@@ -2,12 +2,50 @@
 #pragma once
 #include <JuceHeader.h>
 #include <cmath>
+#include "StageTrace.h"
 
 template <typename SampleType>
 class Fuzz
 {
 public:
 
+    enum class FuzzModel
+    {
+        kHard,
+        kRedux,
+        kFat
+    };
+
+    enum class ToneCharacter
+    {
+        darkest,
+        darker,
+        normal,
+        brighter,
+        brightest
+    };
+
+    enum class OversamplingFilter
+    {
+        polyphaseIIR, //Low latency
+        firEquiripple //Linear phase
+    };
+
+    enum class ShaperMode
+    {
+        analytic,     //Plain transfer function
+        adaa1stOrder, //Antiderivative anti-aliasing, half a sample of delay
+        adaa2ndOrder, //Antiderivative anti-aliasing, one sample of delay
+        lookupTable   //Transfer function read from a shared interpolated table
+    };
+
+    //Wet path filter stages after the shaper that can be bypassed (e.g. when EQ is handled elsewhere in the chain)
+    enum class Stage
+    {
+        dcBlocker,
+        tone
+    };
+
     Fuzz();
 
     void prepare(juce::dsp::ProcessSpec& spec);
@@ -20,211 +58,1615 @@ public:
         const auto& inputBlock = context.getInputBlock();
         auto& outputBlock = context.getOutputBlock();
 
-        const auto numChannels = outputBlock.getNumChannels();
         const auto numSamples = outputBlock.getNumSamples();
 
-        jassert(inputBlock.getNumChannels() == numChannels);
+        jassert(inputBlock.getNumChannels() == outputBlock.getNumChannels());
         jassert(inputBlock.getNumSamples() == numSamples);
+        jassert(outputBlock.getNumChannels() <= _wetBlock.getNumChannels());
 
-        for (size_t n = 0; n < numSamples; ++n)
+        //Once the input has been silent for longer than the tail, the filters have decayed and the block is skipped
+        if (isSilent(inputBlock))
         {
-            for (size_t ch = 0; ch < numChannels; ++ch)
+            _numSilentSamples += static_cast<juce::int64>(numSamples);
+
+            if (_numSilentSamples > _tailLengthInSamples)
             {
-                outputBlock.getChannelPointer(ch)[n] = _dcFilter.processSample(ch, inputBlock.getChannelPointer(ch)[n]); //DC Filter
-                outputBlock.getChannelPointer(ch)[n] = processSample(inputBlock.getChannelPointer(ch)[n], ch);
+                skipSilentBlock(outputBlock);
+                return;
             }
         }
+        else
+        {
+            _numSilentSamples = 0;
+            _isSkippingSilence = false;
+        }
+
+        //Oversampler switches land once per host block, not per tile
+        updateOversampler();
+
+        //Run the engine tile by tile, whatever the host's block size
+        for (size_t start = 0; start < numSamples; start += _tileLength)
+        {
+            const auto length = juce::jmin(numSamples - start, _tileLength);
+
+            processChunk(inputBlock.getSubBlock(start, length), outputBlock.getSubBlock(start, length));
+        }
     }
 
 
     SampleType processSample(SampleType inputSample, int channel) noexcept
+    {
+        //Drive (Drives the Signal)
+        auto wetSignal = processModel(inputSample * juce::Decibels::decibelsToGain(static_cast<SampleType>(_input.getNextValue())));
+
+        //Same rule as the block engine: the blocker runs for Hard and fades out after it
+        if (! _isDcBlockerBypassed)
+        {
+            _dcBlocker.setGeneratesDc(_model == FuzzModel::kHard);
+
+            if (_dcBlocker.isActive())
+                wetSignal = _dcBlocker.processSample(channel, wetSignal);
+        }
+
+        // Apply Filtering
+        if (! _isToneBypassed)
+            wetSignal = _toneFilter.processSample(channel, wetSignal);
+
+        // Dry/Wet mix calculation
+        auto mixValue = static_cast<SampleType>(_mix.getNextValue());
+        auto mix = getDryWeight(mixValue) * inputSample + getWetWeight(mixValue) * wetSignal;
+
+        return mix * juce::Decibels::decibelsToGain(static_cast<SampleType>(_output.getNextValue()));
+    }
+
+
+    SampleType processModel(SampleType drivenSample) noexcept
     {
         //Fuzz Models
         switch (_model)
         {
         case FuzzModel::kHard:
         {
-            return processHardClipper(inputSample);
+            return processHardClipper(drivenSample);
             break;
         }
 
         case FuzzModel::kRedux:
         {
-            return processRedux(inputSample);
+            return processRedux(drivenSample);
             break;
         }
 
         case FuzzModel::kFat:
         {
-            return processFat(inputSample);
+            return processFat(drivenSample);
             break;
         }
 
         }
+
+        return drivenSample;
     }
 
 
 
-    SampleType processHardClipper(SampleType inputSample)
+    static SampleType processHardClipper(SampleType drivenSample) noexcept
     {
-        //Drive (Drives the Signal)
-        auto wetSignal = pow((inputSample * juce::Decibels::decibelsToGain(_input.getNextValue())), 2)
-            + (inputSample * juce::Decibels::decibelsToGain(_input.getNextValue()));
+        auto wetSignal = drivenSample * drivenSample + drivenSample;
 
-        if (std::abs(wetSignal) > 0.99) //If the absolute value of the signal is >1, it distorts
-            //I do it in 0.99 to introduce some "headroom" before full clipping occurs
-        {
-            wetSignal *= 0.99 / std::abs(wetSignal); //Distortion function
-            //The bigger the abs(wetSignal) is, the smaller it becomes
-           //Signals that go beyond 0.99 are "hard clipped" to this range
-        }
+        //If the absolute value of the signal is >1, it distorts
+        //I do it in 0.99 to introduce some "headroom" before full clipping occurs
+        //Signals that go beyond 0.99 are "hard clipped" to this range
+        //(written as a select rather than a branch so the block kernels vectorize)
+        wetSignal = std::abs(wetSignal) > _clipThreshold
+            ? std::copysign(getClipLevel<FuzzModel::kHard>(), wetSignal) //Distortion function
+            : wetSignal;
 
         // Lower the Output Volume cause its too loud
-        wetSignal *= juce::Decibels::decibelsToGain(-6.0f);
+        return wetSignal * getMakeupGain<FuzzModel::kHard>();
+    }
 
-  
-        // Apply Filtering
-        wetSignal = _toneLowPassFilter.processSample(0, wetSignal);
-        wetSignal = _toneHighPassFilter.processSample(0, wetSignal);
-    
 
-        //auto mix = (1.0 - _mix.getNextValue()) * inputSample + wetSignal * _mix.getNextValue(); // Mix Dry/Wet OLD
+    static SampleType processRedux(SampleType drivenSample) noexcept
+    {
+        auto wetSignal = drivenSample * drivenSample * drivenSample + drivenSample;
 
-        // Dry/Wet mix calculation
-        auto mixValue = _mix.getNextValue();
-        auto dryWeight = std::cos(mixValue * juce::MathConstants<float>::halfPi);
-        auto wetWeight = std::pow(std::sin(mixValue * juce::MathConstants<float>::halfPi), 1.5); // Non-linear scaling for wet signal
-        auto mix = dryWeight * inputSample + wetWeight * wetSignal;
+        wetSignal = std::abs(wetSignal) > _clipThreshold
+            ? std::copysign(getClipLevel<FuzzModel::kRedux>(), wetSignal) //Distortion function
+            : wetSignal;
 
-        return mix * juce::Decibels::decibelsToGain(_output.getNextValue());
+        // Lower the Output Volume cause its too loud
+        return wetSignal * getMakeupGain<FuzzModel::kRedux>();
     }
 
 
+    static SampleType processFat(SampleType drivenSample) noexcept
+    {
+        auto wetSignal = drivenSample * drivenSample * drivenSample + drivenSample;
+
+        wetSignal = std::abs(wetSignal) > _clipThreshold
+            ? std::copysign(getClipLevel<FuzzModel::kFat>(), wetSignal) //Distortion function
+            : wetSignal;
+
+        // Lower the Output Volume cause its too loud
+        return wetSignal * getMakeupGain<FuzzModel::kFat>();
+    }
 
 
-    SampleType processRedux(SampleType inputSample)
+    template <FuzzModel Model>
+    static SampleType shapeSample(SampleType drivenSample) noexcept
     {
-        //Drive (Drives the Signal)
-        auto wetSignal = pow((inputSample * juce::Decibels::decibelsToGain(_input.getNextValue())), 3)
-            + (inputSample * juce::Decibels::decibelsToGain(_input.getNextValue()));
+        if constexpr (Model == FuzzModel::kHard)
+            return processHardClipper(drivenSample);
+        else if constexpr (Model == FuzzModel::kRedux)
+            return processRedux(drivenSample);
+        else
+            return processFat(drivenSample);
+    }
 
-        if (std::abs(wetSignal) > 0.99) //If the absolute value of the signal is >1, it distorts
-            //I do it in 0.99 to introduce some "headroom" before full clipping occurs
-        {
-            wetSignal *= 0.99 / std::abs(wetSignal) * 3; //Distortion function
-            //The bigger the abs(wetSignal) is, the smaller it becomes
-           //Signals that go beyond 0.99 are "hard clipped" to this range
-        }
+   #if JUCE_USE_SIMD
+    using SIMDSample = juce::dsp::SIMDRegister<SampleType>;
 
-        // Lower the Output Volume cause its too loud
-        wetSignal *= juce::Decibels::decibelsToGain(-20.0f);
+    //Same transfer functions, SIMDSample::size() consecutive samples at a time
+    template <FuzzModel Model>
+    static SIMDSample shapeSample(SIMDSample drivenSample) noexcept
+    {
+        auto wetSignal = drivenSample * drivenSample + drivenSample;
 
+        if constexpr (Model != FuzzModel::kHard)
+            wetSignal = drivenSample * drivenSample * drivenSample + drivenSample;
 
-        // Apply Filtering
-        wetSignal = _toneLowPassFilter.processSample(0, wetSignal);
-        wetSignal = _toneHighPassFilter.processSample(0, wetSignal);
+        using MaskType = typename SIMDSample::MaskType;
+        using MaskRegister = juce::dsp::SIMDRegister<MaskType>;
 
+        //copysign(clipLevel, wetSignal) as bit operations: sign bit of the signal, magnitude of the clip level
+        constexpr auto negativeZero = static_cast<SampleType>(-0.0);
+        constexpr auto clipLevelValue = getClipLevel<Model>();
+        const auto signBit = MaskRegister::expand(juce::readUnaligned<MaskType>(&negativeZero));
+        const auto clipLevel = MaskRegister::expand(juce::readUnaligned<MaskType>(&clipLevelValue));
+        const auto clippedSignal = (wetSignal & signBit) | clipLevel;
 
-        //auto mix = (1.0 - _mix.getNextValue()) * inputSample + wetSignal * _mix.getNextValue(); // Mix Dry/Wet OLD
+        const auto absSignal = SIMDSample::max(wetSignal, SIMDSample::expand(static_cast<SampleType>(0)) - wetSignal);
+        const auto isClipped = SIMDSample::greaterThan(absSignal, SIMDSample::expand(_clipThreshold));
 
-        // Dry/Wet mix calculation
-        auto mixValue = _mix.getNextValue();
-        auto dryWeight = std::cos(mixValue * juce::MathConstants<float>::halfPi);
-        auto wetWeight = std::pow(std::sin(mixValue * juce::MathConstants<float>::halfPi), 1.5); // Non-linear scaling for wet signal
-        auto mix = dryWeight * inputSample + wetWeight * wetSignal;
+        return ((clippedSignal & isClipped) + (wetSignal & ~isClipped)) * getMakeupGain<Model>();
+    }
+   #endif
 
-        return mix * juce::Decibels::decibelsToGain(_output.getNextValue());
+    template <FuzzModel Model>
+    static constexpr SampleType getClipLevel() noexcept
+    {
+        if constexpr (Model == FuzzModel::kHard)
+            return _clipThreshold;
+        else if constexpr (Model == FuzzModel::kRedux)
+            return _clipThreshold * 3;
+        else
+            return _clipThreshold * static_cast<SampleType>(0.7);
+    }
+
+    //Fixed make-up gains of the models (-6, -20 and -8 dB)
+    template <FuzzModel Model>
+    static constexpr SampleType getMakeupGain() noexcept
+    {
+        if constexpr (Model == FuzzModel::kHard)
+            return static_cast<SampleType>(0.501187233627272);
+        else if constexpr (Model == FuzzModel::kRedux)
+            return static_cast<SampleType>(0.1);
+        else
+            return static_cast<SampleType>(0.398107170553497);
     }
 
 
-    SampleType processFat(SampleType inputSample)
+    static SampleType getDryWeight(SampleType mixValue) noexcept
     {
-        //Drive (Drives the Signal)
-        auto wetSignal = pow((inputSample * juce::Decibels::decibelsToGain(_input.getNextValue())), 3)
-            + (inputSample * juce::Decibels::decibelsToGain(_input.getNextValue()));
+        return std::cos(mixValue * juce::MathConstants<SampleType>::halfPi);
+    }
+
+    static SampleType getWetWeight(SampleType mixValue) noexcept
+    {
+        // Non-linear scaling for wet signal
+        return std::pow(std::sin(mixValue * juce::MathConstants<SampleType>::halfPi), static_cast<SampleType>(1.5));
+    }
+
+
+    void setDrive(SampleType newDrive);
+    void setMix(SampleType newMix);
+    void setOutput(SampleType newOutput);
+    void setFuzzModel(FuzzModel newModel);
+    void setToneCharacter(ToneCharacter newToneChar);
+
+    //Continuous tone on top of the character: -1 sweeps the low-pass down, +1 sweeps the high-pass up (5 octaves each)
+    void setToneSweep(SampleType newSweep);
+    void setShaperMode(ShaperMode newMode);
+
+    //A bypassed stage is left out of the block entirely, switching lands on a block boundary
+    void setStageBypassed(Stage stage, bool shouldBeBypassed);
+    bool isStageBypassed(Stage stage) const noexcept;
+
+    //newFactor is the power of two: 0 = 1x, 1 = 2x, 2 = 4x, 3 = 8x
+    void setOversampling(int newFactor, OversamplingFilter newFilter);
+    int getLatencyInSamples() const noexcept;
+    int getLatencyInSamples(int factor, OversamplingFilter filter) const noexcept;
+
+    //How long the filters ring after the input falls silent, plus the oversampling latency
+    //Any thread: the value is cached whenever a setting it depends on is applied
+    double getTailLengthSeconds() const noexcept { return _tailLengthSeconds.load(std::memory_order_relaxed); }
+
+    //Number of points in each lookup table shaper curve, takes effect at the next prepare()
+    void setShaperTableSize(size_t newNumPoints);
+
+    //Samples per internal tile, takes effect at the next prepare()
+    //Scratch buffers hold one tile, and ramps and model switches are updated once per tile
+    void setTileSize(size_t newTileSize);
+
+   #if FUZZER_TRACE_STAGES
+    //Stage timings of this engine, drained by a StageTraceWriter
+    StageTraceRing& getTraceRing() noexcept { return _traceRing; }
+   #endif
+
+    //Largest difference between the lookup table shaper and the analytic one, per model
+    struct ShaperTableAccuracy
+    {
+        SampleType hard = 0;
+        SampleType redux = 0;
+        SampleType fat = 0;
+    };
+
+    static ShaperTableAccuracy measureShaperTableAccuracy(size_t numPoints);
+
 
-        if (std::abs(wetSignal) > 0.99) //If the absolute value of the signal is >1, it distorts
-            //I do it in 0.99 to introduce some "headroom" before full clipping occurs
+
+private:
+
+    //Linear gain for one block, taken from a smoothed decibel value
+    //While the smoother is idle the gain is a single constant, recomputed only when the target changes, and no ramp is written
+    struct GainRamp
+    {
+        void allocate(size_t maximumBlockSize)
         {
-            wetSignal *= 0.99 / std::abs(wetSignal) * 0.7; //Distortion function
-            //The bigger the abs(wetSignal) is, the smaller it becomes
-           //Signals that go beyond 0.99 are "hard clipped" to this range
+            ramp.allocate(maximumBlockSize, true);
         }
 
-        // Lower the Output Volume cause its too loud
-        wetSignal *= juce::Decibels::decibelsToGain(-8.0f);
+        void fill(juce::SmoothedValue<float>& decibels, int numSamples) noexcept
+        {
+            isSmoothing = decibels.isSmoothing();
 
-       
-        // Apply Filtering
-        wetSignal = _toneLowPassFilter.processSample(0, wetSignal);
-        wetSignal = _toneHighPassFilter.processSample(0, wetSignal);
-       
+            if (isSmoothing)
+            {
+                for (int n = 0; n < numSamples; ++n)
+                    ramp[n] = juce::Decibels::decibelsToGain(static_cast<SampleType>(decibels.getNextValue()));
+            }
+            else if (decibels.getTargetValue() != decibelValue)
+            {
+                decibelValue = decibels.getTargetValue();
+                gain = juce::Decibels::decibelsToGain(static_cast<SampleType>(decibelValue));
+            }
+        }
 
-        //auto mix = (1.0 - _mix.getNextValue()) * inputSample + wetSignal * _mix.getNextValue(); // Mix Dry/Wet OLD
+        void apply(const SampleType* source, SampleType* destination, int numSamples) const noexcept
+        {
+            if (isSmoothing)
+                juce::FloatVectorOperations::multiply(destination, source, ramp.get(), numSamples);
+            else
+                juce::FloatVectorOperations::multiply(destination, source, gain, numSamples);
+        }
 
-        // Dry/Wet mix calculation
-        auto mixValue = _mix.getNextValue();
-        auto dryWeight = std::cos(mixValue * juce::MathConstants<float>::halfPi);
-        auto wetWeight = std::pow(std::sin(mixValue * juce::MathConstants<float>::halfPi), 1.5); // Non-linear scaling for wet signal
-        auto mix = dryWeight * inputSample + wetWeight * wetSignal;
+        juce::HeapBlock<SampleType> ramp;
+        float decibelValue = std::numeric_limits<float>::lowest();
+        SampleType gain = 1;
+        bool isSmoothing = false;
+    };
+
+
+    //Dry/wet curves tabulated once and shared by every instance
+    //Linear interpolation over 512 points stays within 5e-5 of getDryWeight/getWetWeight
+    struct MixCurves
+    {
+        static constexpr size_t numPoints = 512;
+
+        juce::dsp::LookupTableTransform<SampleType> dry{ [](SampleType mixValue) { return getDryWeight(mixValue); },
+            static_cast<SampleType>(0), static_cast<SampleType>(1), numPoints };
 
-        return mix * juce::Decibels::decibelsToGain(_output.getNextValue());
+        juce::dsp::LookupTableTransform<SampleType> wet{ [](SampleType mixValue) { return getWetWeight(mixValue); },
+            static_cast<SampleType>(0), static_cast<SampleType>(1), numPoints };
+    };
+
+    static const MixCurves& getMixCurves()
+    {
+        static const MixCurves curves;
+        return curves;
     }
 
+    //Dry/wet weights for one block
+    //A settled mix uses two exact weights, recomputed only when the target changes
+    //A moving mix reads per-sample weight ramps from the shared curves
+    struct MixWeights
+    {
+        void allocate(size_t maximumBlockSize)
+        {
+            mixRamp.allocate(maximumBlockSize, true);
+            dryRamp.allocate(maximumBlockSize, true);
+            wetRamp.allocate(maximumBlockSize, true);
+
+            getMixCurves(); //Builds the shared tables off the audio thread
+        }
 
-    enum class FuzzModel
+        void fill(juce::SmoothedValue<float>& mix, int numSamples) noexcept
+        {
+            isSmoothing = mix.isSmoothing();
+
+            if (isSmoothing)
+            {
+                for (int n = 0; n < numSamples; ++n)
+                    mixRamp[n] = static_cast<SampleType>(mix.getNextValue());
+
+                const auto& curves = getMixCurves();
+                curves.dry.process(mixRamp.get(), dryRamp.get(), static_cast<size_t>(numSamples));
+                curves.wet.process(mixRamp.get(), wetRamp.get(), static_cast<size_t>(numSamples));
+            }
+            else if (mix.getTargetValue() != mixValue)
+            {
+                mixValue = mix.getTargetValue();
+                dryWeight = getDryWeight(static_cast<SampleType>(mixValue));
+                wetWeight = getWetWeight(static_cast<SampleType>(mixValue));
+            }
+        }
+
+        void apply(const SampleType* dry, SampleType* wet, int numSamples) const noexcept
+        {
+            if (isSmoothing)
+            {
+                juce::FloatVectorOperations::multiply(wet, wetRamp.get(), numSamples);
+                juce::FloatVectorOperations::addWithMultiply(wet, dry, dryRamp.get(), numSamples);
+            }
+            else
+            {
+                juce::FloatVectorOperations::multiply(wet, wetWeight, numSamples);
+                juce::FloatVectorOperations::addWithMultiply(wet, dry, dryWeight, numSamples);
+            }
+        }
+
+        juce::HeapBlock<SampleType> mixRamp;
+        juce::HeapBlock<SampleType> dryRamp;
+        juce::HeapBlock<SampleType> wetRamp;
+        float mixValue = -1.0f;
+        SampleType dryWeight = 1;
+        SampleType wetWeight = 0;
+        bool isSmoothing = false;
+    };
+
+
+    //TPT state variable filter coefficients (the same as juce::dsp::StateVariableTPTFilter computes)
+    struct ToneCoefficients
     {
-        kHard,
-        kRedux,
-        kFat
+        SampleType g = 0;
+        SampleType h = 1;
     };
 
-    enum class ToneCharacter
+    //Both tone filters for one ToneCharacter
+    struct ToneSetting
     {
-        darkest,
-        darker,
-        normal,
-        brighter,
-        brightest
+        double lowPassCutoff = 20000.0;
+        double highPassCutoff = 10.0;
+        ToneCoefficients lowPass;
+        ToneCoefficients highPass;
     };
 
-    void setDrive(SampleType newDrive);
-    void setMix(SampleType newMix);
-    void setOutput(SampleType newOutput);
-    void setFuzzModel(FuzzModel newModel);
-    void setToneCharacter(ToneCharacter newToneChar);
+    using ToneTable = std::array<ToneSetting, 5>; //Indexed by ToneCharacter
 
+    //Every tone setting's coefficients for one sample rate, built on first use and shared by every instance
+    static const ToneTable& getToneTable(double sampleRate);
 
+   #if JUCE_USE_SIMD
+    //Up to SIMDSample::size() channels interleaved into one register per sample, so recursive filters
+    //(which cannot be vectorised along time) run side by side in SIMD lanes. Unused lanes hold silence
+    struct ChannelGroupScratch
+    {
+        void prepare(size_t maximumBlockSize)
+        {
+            block = juce::dsp::AudioBlock<SampleType>(memory, 1, maximumBlockSize * SIMDSample::size());
+        }
 
-private:
+        SampleType* interleave(const juce::dsp::AudioBlock<SampleType>& source, size_t firstChannel, size_t numLanes, int numSamples) noexcept
+        {
+            constexpr auto laneCount = SIMDSample::size();
+            auto* interleaved = block.getChannelPointer(0);
 
+            for (size_t lane = 0; lane < laneCount; ++lane)
+            {
+                if (lane < numLanes)
+                {
+                    const auto* channel = source.getChannelPointer(firstChannel + lane);
 
-    juce::SmoothedValue<float> _input;
-    juce::SmoothedValue<float> _mix;
-    juce::SmoothedValue<float> _output;
+                    for (int n = 0; n < numSamples; ++n)
+                        interleaved[static_cast<size_t>(n) * laneCount + lane] = channel[n];
+                }
+                else
+                {
+                    for (int n = 0; n < numSamples; ++n)
+                        interleaved[static_cast<size_t>(n) * laneCount + lane] = 0;
+                }
+            }
+
+            return interleaved;
+        }
+
+        void deinterleave(const juce::dsp::AudioBlock<SampleType>& destination, size_t firstChannel, size_t numLanes, int numSamples) const noexcept
+        {
+            constexpr auto laneCount = SIMDSample::size();
+            const auto* interleaved = block.getChannelPointer(0);
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto* channel = destination.getChannelPointer(firstChannel + lane);
+
+                for (int n = 0; n < numSamples; ++n)
+                    channel[n] = interleaved[static_cast<size_t>(n) * laneCount + lane];
+            }
+        }
 
-    juce::dsp::LinkwitzRileyFilter<float> _dcFilter;
+        juce::HeapBlock<char> memory;
+        juce::dsp::AudioBlock<SampleType> block;
+    };
+   #endif
 
-    juce::dsp::StateVariableTPTFilter<SampleType> _lowPassFilter; // Low-pass filter
-    float _lowPassCutoff = 1100.0f; //Cutoff frequency 1.1 kHz
 
+    //One-pole DC blocker, H(z) = (1 - z^-1) / (1 - (1 - a) z^-1), with per-channel state
+    //The state is the running DC estimate, which the output subtracts
+    //Channels run in SIMD groups like the tone filters
+    //Only the asymmetric Hard model generates DC: once another model takes over, the output crossfades from blocked
+    //to unblocked over _dcBlockerFadeTimeConstants time constants (the estimate decays meanwhile), then the stage is skipped
+    struct DcBlocker
+    {
+        void prepare(double sampleRate, size_t maximumBlockSize, size_t numChannels)
+        {
+            const auto poleFrequency = juce::MathConstants<double>::twoPi * _dcBlockerCutoff / sampleRate;
 
-    //Tone
-    //Low Pass
-    juce::dsp::StateVariableTPTFilter<SampleType> _toneLowPassFilter; // Low-pass filter
+            coefficient = static_cast<SampleType>(1.0 - std::exp(-poleFrequency));
+            fadeStep = static_cast<SampleType>(poleFrequency / _dcBlockerFadeTimeConstants);
+            offsets.resize(numChannels);
 
-    //High Pass
-    juce::dsp::StateVariableTPTFilter<SampleType> _toneHighPassFilter; // High-pass filter
-    //TONE
+           #if JUCE_USE_SIMD
+            scratch.prepare(maximumBlockSize);
+           #else
+            juce::ignoreUnused(maximumBlockSize);
+           #endif
+        }
 
+        //No estimate, and blocking (Hard) or already faded out (the other models)
+        void clear(bool isBlocking) noexcept
+        {
+            std::fill(offsets.begin(), offsets.end(), static_cast<SampleType>(0));
+            weight = isBlocking ? 1 : 0;
+            isFadingOut = false;
+            isIdle = true;
+        }
 
-    float _piDivisor = 2.0 / juce::MathConstants<float>::pi;
+        //Once per block (or sample, for processSample): back to full blocking for Hard, fading out otherwise
+        //A blocker that has not run since it was cleared holds no estimate, so there is nothing to fade
+        void setGeneratesDc(bool generatesDc) noexcept
+        {
+            if (generatesDc)
+                weight = 1;
+            else if (isIdle)
+                weight = 0;
 
-    float _sampleRate = 44100.0f;
+            isFadingOut = ! generatesDc && weight > 0;
+        }
 
-    FuzzModel _model = FuzzModel::kHard;
-    
-    ToneCharacter _toneChar = ToneCharacter::normal;
+        //False once faded out, the stage can be skipped
+        bool isActive() const noexcept
+        {
+            return weight > 0;
+        }
+
+        void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+        {
+            if (isFadingOut)
+                process<true>(block);
+            else
+                process<false>(block);
+        }
+
+        template <bool IsFading>
+        void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+        {
+            const auto numChannels = block.getNumChannels();
+            const auto numSamples = static_cast<int>(block.getNumSamples());
+            size_t ch = 0;
+
+            isIdle = false;
+
+           #if JUCE_USE_SIMD
+            for (; ch + 1 < numChannels && numSamples >= _minChannelGroupLength; ch += SIMDSample::size())
+                processGroup<IsFading>(block, ch, juce::jmin(SIMDSample::size(), numChannels - ch), numSamples);
+           #endif
+
+            for (; ch < numChannels; ++ch)
+                processChannel<IsFading>(block.getChannelPointer(ch), offsets[ch], numSamples);
+
+            if constexpr (IsFading)
+                advanceFade(numSamples);
+        }
+
+        //Advances the fade per call, the way the scalar path advances its smoothers
+        SampleType processSample(int channel, SampleType inputSample) noexcept
+        {
+            const auto output = processOffset(inputSample, offsets[static_cast<size_t>(channel)], coefficient);
+            isIdle = false;
+
+            if (! isFadingOut)
+                return output;
+
+            const auto faded = inputSample + weight * (output - inputSample);
+            advanceFade(1);
+
+            return faded;
+        }
+
+        //At the end of the fade the estimate has decayed, it is dropped so a return to Hard starts clean
+        void advanceFade(int numSamples) noexcept
+        {
+            weight = juce::jmax(static_cast<SampleType>(0), weight - fadeStep * static_cast<SampleType>(numSamples));
+
+            if (weight == 0)
+                clear(false);
+        }
+
+        //Weight of the blocked signal at each sample of a fade, starting from the current weight
+        SampleType getFadeWeight(int n) const noexcept
+        {
+            return juce::jmax(static_cast<SampleType>(0), weight - fadeStep * static_cast<SampleType>(n));
+        }
+
+        template <typename Value>
+        static Value processOffset(Value input, Value& offset, Value a) noexcept
+        {
+            const auto output = input - offset;
+            offset += a * output;
+            return output;
+        }
+
+        template <bool IsFading>
+        void processChannel(SampleType* wet, SampleType& offset, int numSamples) const noexcept
+        {
+            auto channelOffset = offset;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const auto output = processOffset(wet[n], channelOffset, coefficient);
+
+                if constexpr (IsFading)
+                    wet[n] += getFadeWeight(n) * (output - wet[n]);
+                else
+                    wet[n] = output;
+            }
+
+            offset = channelOffset;
+        }
+
+       #if JUCE_USE_SIMD
+        template <bool IsFading>
+        void processGroup(const juce::dsp::AudioBlock<SampleType>& block, size_t firstChannel, size_t numLanes, int numSamples) noexcept
+        {
+            constexpr auto laneCount = SIMDSample::size();
+            auto* interleaved = scratch.interleave(block, firstChannel, numLanes, numSamples);
+
+            auto offset = SIMDSample::expand(0);
+            const auto a = SIMDSample::expand(coefficient);
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                offset.set(lane, offsets[firstChannel + lane]);
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                auto* frame = interleaved + static_cast<size_t>(n) * laneCount;
+                const auto input = SIMDSample::fromRawArray(frame);
+                auto output = processOffset(input, offset, a);
+
+                if constexpr (IsFading)
+                    output = input + (output - input) * getFadeWeight(n);
+
+                output.copyToRawArray(frame);
+            }
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                offsets[firstChannel + lane] = offset.get(lane);
+
+            scratch.deinterleave(block, firstChannel, numLanes, numSamples);
+        }
+
+        ChannelGroupScratch scratch;
+       #endif
 
-    std::array<SampleType, 2> previousSample = { 0.0f, 0.0f }; // For stereo channels (Not used currently)
+        std::vector<SampleType> offsets; //One per channel, contiguous
+        SampleType coefficient = 0;
+
+        SampleType weight = 1; //Of the blocked signal: 1 while blocking, 0 once faded out
+        SampleType fadeStep = 0;
+        bool isFadingOut = false;
+        bool isIdle = true;
+    };
+
+
+    //Low-pass then high-pass TPT state variable filters for every channel, fused into one cascade per sample
+    //A new setting only swaps coefficients: g moves linearly to the target over a ramp
+    //(h follows from g, one division per sample while ramping), so switching needs no trig
+    //Each filter is a serial recursion, so channels run side by side in SIMD lanes instead:
+    //a group is interleaved into scratch, filtered with one register per state, then written back
+    struct ToneFilterBank
+    {
+        void prepare(size_t maximumBlockSize, size_t numChannels, int newRampLength)
+        {
+            lowPassG.allocate(maximumBlockSize, true);
+            lowPassH.allocate(maximumBlockSize, true);
+            highPassG.allocate(maximumBlockSize, true);
+            highPassH.allocate(maximumBlockSize, true);
+
+           #if JUCE_USE_SIMD
+            scratch.prepare(maximumBlockSize);
+           #endif
+
+            states.resize(numChannels);
+            rampLength = juce::jmax(1, newRampLength);
+        }
+
+        void clear() noexcept
+        {
+            std::fill(states.begin(), states.end(), CascadeState<SampleType>{});
+            isIdle = true;
+        }
+
+        //Filters that have not run since they were cleared take a new setting at once, there is nothing to zipper
+        void setTarget(const ToneSetting& newTarget, int numRampSamples) noexcept
+        {
+            target = newTarget;
+
+            if (numRampSamples <= 0 || isIdle)
+            {
+                jumpToTarget();
+                return;
+            }
+
+            lowPassStep = (target.lowPass.g - current.lowPass.g) / static_cast<SampleType>(numRampSamples);
+            highPassStep = (target.highPass.g - current.highPass.g) / static_cast<SampleType>(numRampSamples);
+            rampRemaining = numRampSamples;
+        }
+
+        void jumpToTarget() noexcept
+        {
+            current = target;
+            rampRemaining = 0;
+        }
+
+        //Coefficients are per sample for the whole block while a ramp runs or the sweep moves
+        void beginBlock(bool isSweeping) noexcept
+        {
+            isSmoothing = isSweeping || rampRemaining > 0;
+            isIdle = false;
+        }
+
+        //Per-sample coefficients for part of the block, shared by all channels
+        void fill(int startSample, int numSamples) noexcept
+        {
+            if (! isSmoothing)
+                return;
+
+            for (int n = startSample; n < startSample + numSamples; ++n)
+            {
+                if (rampRemaining > 0 && --rampRemaining == 0)
+                {
+                    current = target;
+                }
+                else if (rampRemaining > 0)
+                {
+                    current.lowPass = getCoefficients(current.lowPass.g + lowPassStep);
+                    current.highPass = getCoefficients(current.highPass.g + highPassStep);
+                }
+
+                lowPassG[n] = current.lowPass.g;
+                lowPassH[n] = current.lowPass.h;
+                highPassG[n] = current.highPass.g;
+                highPassH[n] = current.highPass.h;
+            }
+        }
+
+        void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+        {
+            const auto numChannels = block.getNumChannels();
+            const auto numSamples = static_cast<int>(block.getNumSamples());
+            size_t ch = 0;
+
+           #if JUCE_USE_SIMD
+            //A lone channel would leave most lanes idle, and a short block would not pay back loading the group,
+            //the scalar loop is cheaper for both
+            for (; ch + 1 < numChannels && numSamples >= _minChannelGroupLength; ch += SIMDSample::size())
+            {
+                const auto numLanes = juce::jmin(SIMDSample::size(), numChannels - ch);
+
+                if (isSmoothing)
+                    processGroup<true>(block, ch, numLanes, numSamples);
+                else
+                    processGroup<false>(block, ch, numLanes, numSamples);
+            }
+           #endif
+
+            for (; ch < numChannels; ++ch)
+            {
+                if (isSmoothing)
+                    processChannel<true>(block.getChannelPointer(ch), states[ch], numSamples);
+                else
+                    processChannel<false>(block.getChannelPointer(ch), states[ch], numSamples);
+            }
+        }
+
+        SampleType processSample(int channel, SampleType inputSample) noexcept
+        {
+            auto& state = states[static_cast<size_t>(channel)];
+
+            return processCascade(inputSample, state, current.lowPass.g, current.lowPass.h,
+                current.highPass.g, current.highPass.h, _toneR2);
+        }
+
+        static ToneCoefficients getCoefficients(SampleType g) noexcept
+        {
+            return { g, static_cast<SampleType>(1) / (static_cast<SampleType>(1) + _toneR2 * g + g * g) };
+        }
+
+        template <typename Value>
+        struct CascadeState
+        {
+            Value lowPass1{};
+            Value lowPass2{};
+            Value highPass1{};
+            Value highPass2{};
+        };
+
+        //One sample through both filters (the same equations as juce::dsp::StateVariableTPTFilter),
+        //written once for plain samples and for SIMD registers
+        template <typename Value>
+        static Value processCascade(Value input, CascadeState<Value>& state, Value lowPassG, Value lowPassH,
+            Value highPassG, Value highPassH, Value r2) noexcept
+        {
+            auto yHP = lowPassH * (input - state.lowPass1 * (lowPassG + r2) - state.lowPass2);
+            auto yBP = yHP * lowPassG + state.lowPass1;
+            state.lowPass1 = yHP * lowPassG + yBP;
+
+            const auto yLP = yBP * lowPassG + state.lowPass2;
+            state.lowPass2 = yBP * lowPassG + yLP;
+
+            yHP = highPassH * (yLP - state.highPass1 * (highPassG + r2) - state.highPass2);
+            yBP = yHP * highPassG + state.highPass1;
+            state.highPass1 = yHP * highPassG + yBP;
+            state.highPass2 = yBP * highPassG + (yBP * highPassG + state.highPass2);
+
+            return yHP;
+        }
+
+        template <bool IsSmoothing>
+        void processChannel(SampleType* wet, CascadeState<SampleType>& state, int numSamples) const noexcept
+        {
+            auto coefficients = current;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                if constexpr (IsSmoothing)
+                {
+                    coefficients.lowPass = { lowPassG[n], lowPassH[n] };
+                    coefficients.highPass = { highPassG[n], highPassH[n] };
+                }
+
+                wet[n] = processCascade(wet[n], state, coefficients.lowPass.g, coefficients.lowPass.h,
+                    coefficients.highPass.g, coefficients.highPass.h, _toneR2);
+            }
+        }
+
+       #if JUCE_USE_SIMD
+        template <bool IsSmoothing>
+        void processGroup(const juce::dsp::AudioBlock<SampleType>& block, size_t firstChannel, size_t numLanes, int numSamples) noexcept
+        {
+            constexpr auto laneCount = SIMDSample::size();
+            auto* interleaved = scratch.interleave(block, firstChannel, numLanes, numSamples);
+
+            //Unused lanes filter silence and are never written back
+            CascadeState<SIMDSample> state{};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                const auto& channelState = states[firstChannel + lane];
+
+                state.lowPass1.set(lane, channelState.lowPass1);
+                state.lowPass2.set(lane, channelState.lowPass2);
+                state.highPass1.set(lane, channelState.highPass1);
+                state.highPass2.set(lane, channelState.highPass2);
+            }
+
+            const auto r2 = SIMDSample::expand(_toneR2);
+            auto lpG = SIMDSample::expand(current.lowPass.g);
+            auto lpH = SIMDSample::expand(current.lowPass.h);
+            auto hpG = SIMDSample::expand(current.highPass.g);
+            auto hpH = SIMDSample::expand(current.highPass.h);
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                if constexpr (IsSmoothing)
+                {
+                    lpG = SIMDSample::expand(lowPassG[n]);
+                    lpH = SIMDSample::expand(lowPassH[n]);
+                    hpG = SIMDSample::expand(highPassG[n]);
+                    hpH = SIMDSample::expand(highPassH[n]);
+                }
+
+                auto* frame = interleaved + static_cast<size_t>(n) * laneCount;
+                processCascade(SIMDSample::fromRawArray(frame), state, lpG, lpH, hpG, hpH, r2).copyToRawArray(frame);
+            }
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                states[firstChannel + lane] = { state.lowPass1.get(lane), state.lowPass2.get(lane),
+                    state.highPass1.get(lane), state.highPass2.get(lane) };
+
+            scratch.deinterleave(block, firstChannel, numLanes, numSamples);
+        }
+
+        ChannelGroupScratch scratch;
+       #endif
+
+        std::vector<CascadeState<SampleType>> states; //One per channel, contiguous
+
+        juce::HeapBlock<SampleType> lowPassG;
+        juce::HeapBlock<SampleType> lowPassH;
+        juce::HeapBlock<SampleType> highPassG;
+        juce::HeapBlock<SampleType> highPassH;
+
+        ToneSetting current;
+        ToneSetting target;
+        SampleType lowPassStep = 0;
+        SampleType highPassStep = 0;
+        int rampLength = 1;
+        int rampRemaining = 0;
+        bool isSmoothing = false;
+        bool isIdle = true;
+    };
+
+
+    //Last two driven samples of a channel, the history the ADAA kernels difference against
+    struct AntiderivativeState
+    {
+        double x1 = 0.0;
+        double x2 = 0.0;
+    };
+
+
+    //Model transfer functions (make-up gain included) tabulated over the driven signal
+    //The transfer depends on the input and drive only through their product, so one curve per model
+    //covers every drive setting. Each curve spans exactly the two knees, where the polynomial is smooth,
+    //and the clip levels outside them are selected exactly (the Redux and Fat levels jump at the knee)
+    struct WaveshaperTables
+    {
+        explicit WaveshaperTables(size_t numPoints)
+            : hard(makeCurve<FuzzModel::kHard>(numPoints)),
+              redux(makeCurve<FuzzModel::kRedux>(numPoints)),
+              fat(makeCurve<FuzzModel::kFat>(numPoints))
+        {
+        }
+
+        template <FuzzModel Model>
+        static juce::dsp::LookupTableTransform<SampleType> makeCurve(size_t numPoints)
+        {
+            return { [](SampleType drivenSample) { return shapeSample<Model>(drivenSample); },
+                static_cast<SampleType>(TransferCurve<Model>::lowerKnee),
+                static_cast<SampleType>(TransferCurve<Model>::upperKnee), numPoints };
+        }
+
+        template <FuzzModel Model>
+        SampleType transfer(SampleType drivenSample) const noexcept
+        {
+            using Curve = TransferCurve<Model>;
+            constexpr auto lowerKnee = static_cast<SampleType>(Curve::lowerKnee);
+            constexpr auto upperKnee = static_cast<SampleType>(Curve::upperKnee);
+            constexpr auto upperLevel = static_cast<SampleType>(Curve::upperLevel) * getMakeupGain<Model>();
+            constexpr auto lowerLevel = static_cast<SampleType>(Curve::lowerLevel) * getMakeupGain<Model>();
+
+            const auto tabulated = get<Model>().processSampleUnchecked(juce::jlimit(lowerKnee, upperKnee, drivenSample));
+
+            return drivenSample > upperKnee ? upperLevel
+                 : drivenSample < lowerKnee ? lowerLevel
+                 : tabulated;
+        }
+
+        template <FuzzModel Model>
+        const juce::dsp::LookupTableTransform<SampleType>& get() const noexcept
+        {
+            if constexpr (Model == FuzzModel::kHard)
+                return hard;
+            else if constexpr (Model == FuzzModel::kRedux)
+                return redux;
+            else
+                return fat;
+        }
+
+        juce::dsp::LookupTableTransform<SampleType> hard;
+        juce::dsp::LookupTableTransform<SampleType> redux;
+        juce::dsp::LookupTableTransform<SampleType> fat;
+    };
+
+    //One set of tables per resolution, built on first use and shared by every instance
+    static const WaveshaperTables& getWaveshaperTables(size_t numPoints)
+    {
+        static juce::CriticalSection lock;
+        static std::map<size_t, std::unique_ptr<WaveshaperTables>> tables;
+
+        const juce::ScopedLock sl(lock);
+        auto& entry = tables[numPoints];
+
+        if (entry == nullptr)
+            entry = std::make_unique<WaveshaperTables>(numPoints);
+
+        return *entry;
+    }
+
+    using ShaperKernel = void (*)(const SampleType*, SampleType*, const GainRamp&, AntiderivativeState&,
+        const WaveshaperTables&, int) noexcept;
+
+    //Block engine: every channel runs as a contiguous run through each stage
+    void processChunk(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+        const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+    {
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = static_cast<int>(outputBlock.getNumSamples());
+
+        //The smoothers advance once per sample, shared by all channels
+        fillParameterRamps(numSamples);
+
+        //Model and shaper changes land on a block boundary, crossfading from the old kernel over this block
+        const auto model = _model;
+        const auto shaperMode = _shaperMode;
+        const auto isSwitching = model != _activeModel || shaperMode != _activeShaperMode;
+
+        //Only the asymmetric Hard model generates DC, the cubic models skip the blocker once it has faded out
+        _dcBlocker.setGeneratesDc(model == FuzzModel::kHard);
+
+        const auto isDcBlocking = ! _isDcBlockerBypassed && _dcBlocker.isActive();
+
+        //Pipeline: dry copy -> drive and shaper (oversampled) -> DC blocker -> tone -> mix -> output
+        const auto wetStages = getWetStages(isDcBlocking, ! _isToneBypassed);
+
+        if (_oversampler == nullptr)
+        {
+            const auto shaperKernel = getShaperKernel(_activeModel, _activeShaperMode, _inputGain);
+            const auto crossfadeKernel = isSwitching ? getShaperKernel(model, shaperMode, _inputGain) : nullptr;
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* dry = _dryBlock.getChannelPointer(ch);
+                auto* wet = _wetBlock.getChannelPointer(ch);
+
+                processDry(inputBlock.getChannelPointer(ch), dry, numSamples);
+                processShaper(shaperKernel, crossfadeKernel, dry, wet, _inputGain, _antiderivativeStates[ch], numSamples);
+            }
+
+            (this->*wetStages)(_wetBlock.getSubsetChannelBlock(0, numChannels).getSubBlock(0, static_cast<size_t>(numSamples)), outputBlock);
+        }
+        else
+        {
+            //Only the nonlinear stage runs oversampled, the drive gain is applied before upsampling
+            const auto shaperKernel = getShaperKernel(_activeModel, _activeShaperMode, _unityGain);
+            const auto crossfadeKernel = isSwitching ? getShaperKernel(model, shaperMode, _unityGain) : nullptr;
+
+            auto wetBlock = _wetBlock.getSubsetChannelBlock(0, numChannels).getSubBlock(0, static_cast<size_t>(numSamples));
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                processDry(inputBlock.getChannelPointer(ch), _dryBlock.getChannelPointer(ch), numSamples);
+
+                FUZZ_TRACE_STAGE(_traceRing, TraceStage::drive);
+                _inputGain.apply(_dryBlock.getChannelPointer(ch), wetBlock.getChannelPointer(ch), numSamples);
+            }
+
+            juce::dsp::AudioBlock<SampleType> oversampledBlock;
+
+            {
+                FUZZ_TRACE_STAGE(_traceRing, TraceStage::oversamplingUp);
+                oversampledBlock = _oversampler->processSamplesUp(wetBlock);
+            }
+            const auto numOversampledSamples = static_cast<int>(oversampledBlock.getNumSamples());
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* oversampled = oversampledBlock.getChannelPointer(ch);
+                processShaper(shaperKernel, crossfadeKernel, oversampled, oversampled, _unityGain,
+                    _antiderivativeStates[ch], numOversampledSamples);
+            }
+
+            {
+                FUZZ_TRACE_STAGE(_traceRing, TraceStage::oversamplingDown);
+                _oversampler->processSamplesDown(wetBlock);
+            }
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                processDryDelay(_dryBlock.getChannelPointer(ch), static_cast<int>(ch), numSamples);
+
+            (this->*wetStages)(wetBlock, outputBlock);
+        }
+
+        _activeModel = model;
+        _activeShaperMode = shaperMode;
+    }
+
+    //DC blocker, tone, mix and output stages, shared by both shaper paths
+    //The tone bank takes all channels at once, the rest runs per channel
+    template <bool IsDcBlocking, bool IsToneEnabled>
+    void processWetAndMix(const juce::dsp::AudioBlock<SampleType>& wetBlock, const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+    {
+        const auto numSamples = static_cast<int>(wetBlock.getNumSamples());
+
+        if constexpr (IsDcBlocking)
+            processDcBlocker(wetBlock);
+
+        if constexpr (IsToneEnabled)
+            processTone(wetBlock);
+
+        for (size_t ch = 0; ch < wetBlock.getNumChannels(); ++ch)
+        {
+            auto* wet = wetBlock.getChannelPointer(ch);
+
+            processMix(_dryBlock.getChannelPointer(ch), wet, numSamples);
+            processOutput(wet, outputBlock.getChannelPointer(ch), numSamples);
+        }
+    }
+
+    //One instantiation of the wet stages per set of active stages, picked once per block,
+    //so a bypassed stage is compiled out rather than branched around
+    using WetStages = void (Fuzz::*)(const juce::dsp::AudioBlock<SampleType>&, const juce::dsp::AudioBlock<SampleType>&) noexcept;
+
+    static WetStages getWetStages(bool isDcBlocking, bool isToneEnabled) noexcept
+    {
+        if (isDcBlocking)
+            return isToneEnabled ? &Fuzz::processWetAndMix<true, true> : &Fuzz::processWetAndMix<true, false>;
+
+        return isToneEnabled ? &Fuzz::processWetAndMix<false, true> : &Fuzz::processWetAndMix<false, false>;
+    }
+
+    void processShaper(ShaperKernel shaperKernel, ShaperKernel crossfadeKernel, const SampleType* source, SampleType* wet,
+        const GainRamp& drive, AntiderivativeState& state, int numSamples) noexcept
+    {
+        //Without oversampling the drive is fused into the kernel and timed as part of the shaper
+        FUZZ_TRACE_STAGE(_traceRing, TraceStage::shaper);
+
+        if (crossfadeKernel == nullptr)
+        {
+            shaperKernel(source, wet, drive, state, *_waveshaperTables, numSamples);
+            return;
+        }
+
+        auto* incoming = _crossfadeBlock.getChannelPointer(0);
+
+        //Both kernels start from the same history, and leave the same one behind
+        auto incomingState = state;
+
+        crossfadeKernel(source, incoming, drive, incomingState, *_waveshaperTables, numSamples);
+        shaperKernel(source, wet, drive, state, *_waveshaperTables, numSamples);
+        processCrossfade(incoming, wet, numSamples);
+    }
+
+    void fillParameterRamps(int numSamples) noexcept
+    {
+        if (_isToneBypassed)
+            skipToneCoefficients(numSamples);
+        else
+            fillToneCoefficients(numSamples);
+
+        _inputGain.fill(_input, numSamples);
+        _outputGain.fill(_output, numSamples);
+        _mixWeights.fill(_mix, numSamples);
+    }
+
+    void fillToneCoefficients(int numSamples) noexcept
+    {
+        const auto isSweeping = _toneSweep.isSmoothing();
+
+        _toneFilter.beginBlock(isSweeping);
+
+        if (! isSweeping)
+        {
+            _toneFilter.fill(0, numSamples);
+            return;
+        }
+
+        //Control rate: a new target every _toneControlInterval samples, g ramps linearly in between
+        for (int start = 0; start < numSamples; start += _toneControlInterval)
+        {
+            const auto length = juce::jmin(_toneControlInterval, numSamples - start);
+
+            _toneFilter.setTarget(getToneSetting(_toneChar, _toneSweep.skip(length)), length);
+            _toneFilter.fill(start, length);
+        }
+    }
+
+    //Keeps the sweep moving and the target current while the tone filters are not running
+    void skipToneCoefficients(int numSamples) noexcept
+    {
+        if (_toneSweep.isSmoothing())
+            _toneFilter.setTarget(getToneSetting(_toneChar, _toneSweep.skip(numSamples)), 0);
+        else
+            _toneFilter.jumpToTarget();
+    }
+
+    //The character's preset coefficients, or (with the sweep away from 0) cutoffs moved by the sweep
+    //and coefficients from a fast tan approximation
+    ToneSetting getToneSetting(ToneCharacter toneChar, float sweep) const noexcept;
+
+    //Dry path (the shaper and the mix both start from the input)
+    void processDry(const SampleType* input, SampleType* dry, int numSamples) noexcept
+    {
+        juce::FloatVectorOperations::copy(dry, input, numSamples);
+    }
+
+    //DC Filter, after the shaper where the DC is generated (and after downsampling)
+    void processDcBlocker(const juce::dsp::AudioBlock<SampleType>& wetBlock) noexcept
+    {
+        FUZZ_TRACE_STAGE(_traceRing, TraceStage::dcBlocker);
+        _dcBlocker.process(wetBlock);
+    }
+
+    //Delays the dry path by the oversampling latency so the mix stays phase aligned
+    void processDryDelay(SampleType* dry, int channel, int numSamples) noexcept
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            _dryDelay.pushSample(channel, dry[n]);
+            dry[n] = _dryDelay.popSample(channel);
+        }
+    }
+
+    int getOversamplerIndex() const noexcept;
+    int getOversamplerIndex(int factor, OversamplingFilter filter) const noexcept;
+
+    //A single compare while the setting stands, the switch itself is out of line
+    void updateOversampler() noexcept
+    {
+        if (_oversamplerIndex != _activeOversamplerIndex)
+            switchOversampler();
+    }
+
+    void switchOversampler() noexcept;
+
+    //Silence detection: vectorized peak search over every input channel
+    //Audio almost never ends a block on a silent sample, so the last sample of each channel settles most blocks
+    bool isSilent(const juce::dsp::AudioBlock<const SampleType>& inputBlock) const noexcept
+    {
+        const auto numSamples = static_cast<int>(inputBlock.getNumSamples());
+
+        if (numSamples == 0)
+            return true;
+
+        for (size_t ch = 0; ch < inputBlock.getNumChannels(); ++ch)
+            if (std::abs(inputBlock.getSample(static_cast<int>(ch), numSamples - 1)) > _silenceThreshold)
+                return false;
+
+        for (size_t ch = 0; ch < inputBlock.getNumChannels(); ++ch)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(inputBlock.getChannelPointer(ch), numSamples);
+
+            if (juce::jmax(-range.getStart(), range.getEnd()) > _silenceThreshold)
+                return false;
+        }
+
+        return true;
+    }
+
+    //Recomputes the cached tail from the settings last applied (tone target, bypassed stages, oversampling)
+    void updateTailLength() noexcept;
+
+    //Outputs silence without running the engine, parameters and model changes still move on
+    void skipSilentBlock(const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+    {
+        const auto numSamples = static_cast<int>(outputBlock.getNumSamples());
+
+        //What is left in the filters is below the silence threshold, so the engine resumes from a clean state
+        if (! _isSkippingSilence)
+        {
+            clearProcessingState();
+            _isSkippingSilence = true;
+        }
+
+        outputBlock.clear();
+
+        _input.skip(numSamples);
+        _mix.skip(numSamples);
+        _output.skip(numSamples);
+
+        updateOversampler();
+        _activeModel = _model;
+        _activeShaperMode = _shaperMode;
+
+        skipToneCoefficients(numSamples);
+    }
+
+    void clearProcessingState() noexcept;
+
+    //Drive (Drives the Signal) and Fuzz Models, fused into one branch-free kernel per model
+    //and per drive state (constant gain or smoothing ramp)
+    template <FuzzModel Model, bool IsSmoothing>
+    static void processDriveAndShaper(const SampleType* dry, SampleType* wet, const GainRamp& drive,
+        AntiderivativeState& state, const WaveshaperTables&, int numSamples) noexcept
+    {
+        const auto* gainRamp = drive.ramp.get();
+        const auto gain = drive.gain;
+        int n = 0;
+
+       #if JUCE_USE_SIMD
+        //SIMD body over aligned runs, the scalar loop below finishes the tail
+        if (SIMDSample::isSIMDAligned(dry) && SIMDSample::isSIMDAligned(wet)
+            && (! IsSmoothing || SIMDSample::isSIMDAligned(gainRamp)))
+        {
+            constexpr auto step = static_cast<int>(SIMDSample::size());
+            const auto constantGain = SIMDSample::expand(gain);
+
+            for (; n + step <= numSamples; n += step)
+            {
+                SIMDSample driveGain = constantGain;
+
+                if constexpr (IsSmoothing)
+                    driveGain = SIMDSample::fromRawArray(gainRamp + n);
+
+                shapeSample<Model>(SIMDSample::fromRawArray(dry + n) * driveGain).copyToRawArray(wet + n);
+            }
+        }
+       #endif
+
+        for (; n < numSamples; ++n)
+        {
+            if constexpr (IsSmoothing)
+                wet[n] = shapeSample<Model>(dry[n] * gainRamp[n]);
+            else
+                wet[n] = shapeSample<Model>(dry[n] * gain);
+        }
+
+        //Keeps the history current, so switching to an ADAA kernel starts without a step
+        for (n = juce::jmax(0, numSamples - 2); n < numSamples; ++n)
+        {
+            state.x2 = state.x1;
+            state.x1 = static_cast<double>(dry[n]) * (IsSmoothing ? gainRamp[n] : gain);
+        }
+    }
+
+    //Closed-form antiderivatives of the model transfer functions (before make-up gain)
+    //Each model is its drive polynomial between two knees and a constant clip level outside them
+    template <FuzzModel Model>
+    struct TransferCurve
+    {
+        static constexpr bool isHard = Model == FuzzModel::kHard;
+
+        //Where the polynomial reaches the clip threshold: roots of d^2 + d = 0.99 and d^3 + d = 0.99
+        static constexpr double upperKnee = isHard ? 0.6135528725660044 : 0.6781404794251314;
+        static constexpr double lowerKnee = isHard ? -1.6135528725660044 : -0.6781404794251314;
+
+        //The hard model clips both sides to the positive level, the cubic models keep the sign
+        static constexpr double upperLevel = static_cast<double>(getClipLevel<Model>());
+        static constexpr double lowerLevel = isHard ? upperLevel : -upperLevel;
+
+        static double polynomial(double d) noexcept
+        {
+            return isHard ? d * d + d : d * d * d + d;
+        }
+
+        static double polynomialFirst(double d) noexcept
+        {
+            const auto d2 = d * d;
+            return isHard ? d2 * d / 3.0 + d2 / 2.0 : d2 * d2 / 4.0 + d2 / 2.0;
+        }
+
+        static double polynomialSecond(double d) noexcept
+        {
+            const auto d3 = d * d * d;
+            return isHard ? d3 * d / 12.0 + d3 / 6.0 : d3 * d * d / 20.0 + d3 / 6.0;
+        }
+
+        static double transfer(double d) noexcept
+        {
+            if (d > upperKnee) return upperLevel;
+            if (d < lowerKnee) return lowerLevel;
+
+            return polynomial(d);
+        }
+
+        static double firstAntiderivative(double d) noexcept
+        {
+            if (d > upperKnee) return polynomialFirst(upperKnee) + upperLevel * (d - upperKnee);
+            if (d < lowerKnee) return polynomialFirst(lowerKnee) + lowerLevel * (d - lowerKnee);
+
+            return polynomialFirst(d);
+        }
+
+        static double secondAntiderivative(double d) noexcept
+        {
+            if (d > upperKnee)
+            {
+                const auto t = d - upperKnee;
+                return polynomialSecond(upperKnee) + polynomialFirst(upperKnee) * t + upperLevel * t * t / 2.0;
+            }
+
+            if (d < lowerKnee)
+            {
+                const auto t = d - lowerKnee;
+                return polynomialSecond(lowerKnee) + polynomialFirst(lowerKnee) * t + lowerLevel * t * t / 2.0;
+            }
+
+            return polynomialSecond(d);
+        }
+    };
+
+    //First-order ADAA: the transfer function averaged between consecutive driven samples
+    //Runs in double, the antiderivative differences lose too many digits in float
+    template <FuzzModel Model, bool IsSmoothing>
+    static void processDriveAndFirstOrderAdaa(const SampleType* dry, SampleType* wet, const GainRamp& drive,
+        AntiderivativeState& state, const WaveshaperTables&, int numSamples) noexcept
+    {
+        using Curve = TransferCurve<Model>;
+        constexpr auto makeupGain = static_cast<double>(getMakeupGain<Model>());
+
+        auto x1 = state.x1;
+        auto x2 = state.x2;
+        auto antiderivative1 = Curve::firstAntiderivative(x1);
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const auto x0 = static_cast<double>(dry[n]) * (IsSmoothing ? drive.ramp[n] : drive.gain);
+            const auto antiderivative0 = Curve::firstAntiderivative(x0);
+            const auto delta = x0 - x1;
+
+            //Nearly equal samples would only divide rounding noise, the midpoint is the limit
+            const auto wetSignal = std::abs(delta) < _adaaTolerance ? Curve::transfer((x0 + x1) / 2.0)
+                                                                   : (antiderivative0 - antiderivative1) / delta;
+
+            wet[n] = static_cast<SampleType>(wetSignal * makeupGain);
+
+            x2 = x1;
+            x1 = x0;
+            antiderivative1 = antiderivative0;
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+    }
+
+    //Second-order ADAA: the divided difference of the second antiderivative over three samples
+    template <FuzzModel Model, bool IsSmoothing>
+    static void processDriveAndSecondOrderAdaa(const SampleType* dry, SampleType* wet, const GainRamp& drive,
+        AntiderivativeState& state, const WaveshaperTables&, int numSamples) noexcept
+    {
+        using Curve = TransferCurve<Model>;
+        constexpr auto makeupGain = static_cast<double>(getMakeupGain<Model>());
+
+        auto x1 = state.x1;
+        auto x2 = state.x2;
+        auto antiderivative1 = Curve::secondAntiderivative(x1);
+        auto difference1 = getAntiderivativeDifference<Model>(x1, x2, antiderivative1, Curve::secondAntiderivative(x2));
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const auto x0 = static_cast<double>(dry[n]) * (IsSmoothing ? drive.ramp[n] : drive.gain);
+            const auto antiderivative0 = Curve::secondAntiderivative(x0);
+            const auto difference0 = getAntiderivativeDifference<Model>(x0, x1, antiderivative0, antiderivative1);
+            const auto span = x0 - x2;
+
+            double wetSignal;
+
+            if (std::abs(span) >= _adaaTolerance)
+            {
+                wetSignal = 2.0 * (difference0 - difference1) / span;
+            }
+            else
+            {
+                //x0 and x2 nearly equal: expand around their midpoint instead
+                const auto midpoint = (x0 + x2) / 2.0;
+                const auto delta = midpoint - x1;
+
+                wetSignal = std::abs(delta) < _adaaTolerance
+                    ? Curve::transfer((midpoint + x1) / 2.0)
+                    : 2.0 / delta * (Curve::firstAntiderivative(midpoint)
+                                     + (antiderivative1 - Curve::secondAntiderivative(midpoint)) / delta);
+            }
+
+            wet[n] = static_cast<SampleType>(wetSignal * makeupGain);
+
+            x2 = x1;
+            x1 = x0;
+            antiderivative1 = antiderivative0;
+            difference1 = difference0;
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+    }
+
+    //Drive, then the model's shared table (linear interpolation between the knees, clip levels outside)
+    template <FuzzModel Model>
+    static void processDriveAndLookupTable(const SampleType* dry, SampleType* wet, const GainRamp& drive,
+        AntiderivativeState& state, const WaveshaperTables& tables, int numSamples) noexcept
+    {
+        drive.apply(dry, wet, numSamples);
+
+        //Keeps the history current, so switching to an ADAA kernel starts without a step
+        for (int n = juce::jmax(0, numSamples - 2); n < numSamples; ++n)
+        {
+            state.x2 = state.x1;
+            state.x1 = static_cast<double>(wet[n]);
+        }
+
+        for (int n = 0; n < numSamples; ++n)
+            wet[n] = tables.template transfer<Model>(wet[n]);
+    }
+
+    //(F2(x0) - F2(x1)) / (x0 - x1), falling back to F1 at the midpoint when the samples nearly meet
+    template <FuzzModel Model>
+    static double getAntiderivativeDifference(double x0, double x1, double antiderivative0, double antiderivative1) noexcept
+    {
+        const auto delta = x0 - x1;
+
+        if (std::abs(delta) < _adaaTolerance)
+            return TransferCurve<Model>::firstAntiderivative((x0 + x1) / 2.0);
+
+        return (antiderivative0 - antiderivative1) / delta;
+    }
+
+    template <FuzzModel Model, bool IsSmoothing>
+    static ShaperKernel getShaperKernel(ShaperMode mode) noexcept
+    {
+        switch (mode)
+        {
+        case ShaperMode::analytic:     return &Fuzz::processDriveAndShaper<Model, IsSmoothing>;
+        case ShaperMode::adaa1stOrder: return &Fuzz::processDriveAndFirstOrderAdaa<Model, IsSmoothing>;
+        case ShaperMode::adaa2ndOrder: return &Fuzz::processDriveAndSecondOrderAdaa<Model, IsSmoothing>;
+        case ShaperMode::lookupTable:  return &Fuzz::processDriveAndLookupTable<Model>;
+        }
+
+        return &Fuzz::processDriveAndShaper<Model, IsSmoothing>;
+    }
+
+    template <FuzzModel Model>
+    static ShaperKernel getShaperKernel(ShaperMode mode, const GainRamp& drive) noexcept
+    {
+        if (drive.isSmoothing)
+            return getShaperKernel<Model, true>(mode);
+
+        return getShaperKernel<Model, false>(mode);
+    }
+
+    static ShaperKernel getShaperKernel(FuzzModel model, ShaperMode mode, const GainRamp& drive) noexcept
+    {
+        switch (model)
+        {
+        case FuzzModel::kHard:  return getShaperKernel<FuzzModel::kHard>(mode, drive);
+        case FuzzModel::kRedux: return getShaperKernel<FuzzModel::kRedux>(mode, drive);
+        case FuzzModel::kFat:   return getShaperKernel<FuzzModel::kFat>(mode, drive);
+        }
+
+        return getShaperKernel<FuzzModel::kHard>(mode, drive);
+    }
+
+    //Linear crossfade from the current wet signal to the new model's output
+    void processCrossfade(const SampleType* incoming, SampleType* wet, int numSamples) noexcept
+    {
+        const auto step = static_cast<SampleType>(1) / static_cast<SampleType>(numSamples);
+
+        for (int n = 0; n < numSamples; ++n)
+            wet[n] += (incoming[n] - wet[n]) * step * static_cast<SampleType>(n + 1);
+    }
+
+    // Apply Filtering
+    void processTone(const juce::dsp::AudioBlock<SampleType>& wetBlock) noexcept
+    {
+        FUZZ_TRACE_STAGE(_traceRing, TraceStage::tone);
+        _toneFilter.process(wetBlock);
+    }
+
+    // Dry/Wet mix calculation
+    void processMix(const SampleType* dry, SampleType* wet, int numSamples) noexcept
+    {
+        FUZZ_TRACE_STAGE(_traceRing, TraceStage::mix);
+        _mixWeights.apply(dry, wet, numSamples);
+    }
+
+    void processOutput(const SampleType* wet, SampleType* output, int numSamples) noexcept
+    {
+        FUZZ_TRACE_STAGE(_traceRing, TraceStage::output);
+        _outputGain.apply(wet, output, numSamples);
+    }
+
+
+    juce::SmoothedValue<float> _input;
+    juce::SmoothedValue<float> _mix;
+    juce::SmoothedValue<float> _output;
+    juce::SmoothedValue<float> _toneSweep;
+
+    //Per-block parameter ramps and dry/wet scratch buffers (allocated in prepare)
+    GainRamp _inputGain;
+    GainRamp _outputGain;
+    MixWeights _mixWeights;
+
+    juce::HeapBlock<char> _dryMemory;
+    juce::HeapBlock<char> _wetMemory;
+    juce::dsp::AudioBlock<SampleType> _dryBlock;
+    juce::dsp::AudioBlock<SampleType> _wetBlock;
+    juce::HeapBlock<char> _crossfadeMemory;
+    juce::dsp::AudioBlock<SampleType> _crossfadeBlock;
+
+    //Tiles: the scratch buffers hold _tileLength samples (the tile size, or less for small host blocks)
+    static constexpr size_t _defaultTileSize = 256;
+    size_t _tileSize = _defaultTileSize;
+    size_t _tileLength = 0;
+
+   #if FUZZER_TRACE_STAGES
+    StageTraceRing _traceRing;
+   #endif
+
+    static constexpr SampleType _clipThreshold = static_cast<SampleType>(0.99);
+
+    //Below this spacing between driven samples the ADAA kernels use their limit forms
+    static constexpr double _adaaTolerance = 1.0e-5;
+
+    std::vector<AntiderivativeState> _antiderivativeStates; //One per channel
+
+    //Silence skipping (-120 dB, and the filters counted as decayed after 18 time constants of the slowest pole pair)
+    static constexpr SampleType _silenceThreshold = static_cast<SampleType>(1.0e-6);
+    static constexpr double _tailTimeConstants = 18.0;
+
+    juce::int64 _numSilentSamples = 0;
+    bool _isSkippingSilence = false;
+
+    //Tail of the applied settings, in seconds for the host's thread and in samples for the silence check
+    std::atomic<double> _tailLengthSeconds{ 0.0 };
+    juce::int64 _tailLengthInSamples = 0;
+
+    //Lookup table shaper, shared with every other instance at the same resolution
+    static constexpr size_t _defaultShaperTableSize = 1024;
+
+    size_t _shaperTableSize = _defaultShaperTableSize;
+    const WaveshaperTables* _waveshaperTables = nullptr;
+
+    //Oversampling: one pre-built oversampler per factor and filter type, switched at block boundaries
+    static constexpr int _maxOversamplingFactor = 3; //2^3 = 8x
+
+    juce::OwnedArray<juce::dsp::Oversampling<SampleType>> _oversamplers;
+    juce::dsp::Oversampling<SampleType>* _oversampler = nullptr;
+    int _oversamplingFactor = 0;
+    OversamplingFilter _oversamplingFilter = OversamplingFilter::polyphaseIIR;
+    int _oversamplerIndex = -1; //Index of the current setting, kept by setOversampling() and prepare()
+    int _activeOversamplerIndex = -1;
+
+    juce::dsp::DelayLine<SampleType, juce::dsp::DelayLineInterpolationTypes::None> _dryDelay;
+
+    GainRamp _unityGain;
+
+    //Shortest block the filters interleave channel groups for, below it the per-channel loops are cheaper
+    static constexpr int _minChannelGroupLength = 16;
+
+    DcBlocker _dcBlocker;
+    static constexpr double _dcBlockerCutoff = 10.0;
+    static constexpr double _dcBlockerFadeTimeConstants = 4.0;
+    bool _isDcBlockerBypassed = false;
+
+
+    //Tone (Low Pass, then High Pass)
+    ToneFilterBank _toneFilter;
+    const ToneTable* _toneTable = nullptr;
+
+    static constexpr SampleType _toneR2 = juce::MathConstants<SampleType>::sqrt2; //1 / resonance, Butterworth
+    static constexpr double _toneRampSeconds = 0.005;
+    static constexpr int _toneControlInterval = 32;
+    static constexpr double _toneSweepOctaves = 5.0;
+    static constexpr double _fastTanLimit = 0.4; //Proportion of the sample rate the swept cutoffs use the fast tan below
+    bool _isToneBypassed = false;
+
+    float _sampleRate = 44100.0f;
+
+    FuzzModel _model = FuzzModel::kHard;
+    FuzzModel _activeModel = FuzzModel::kHard; //Model the block kernels are currently running
+
+    ShaperMode _shaperMode = ShaperMode::analytic;
+    ShaperMode _activeShaperMode = ShaperMode::analytic;
+
+    ToneCharacter _toneChar = ToneCharacter::normal;
 };
@@ -0,0 +1,101 @@
+#include "StageTrace.h"
+
+#if FUZZER_TRACE_STAGES
+
+namespace
+{
+    const char* getStageName(TraceStage stage) noexcept
+    {
+        switch (stage)
+        {
+        case TraceStage::drive:            return "drive";
+        case TraceStage::oversamplingUp:   return "oversampling up";
+        case TraceStage::shaper:           return "shaper";
+        case TraceStage::oversamplingDown: return "oversampling down";
+        case TraceStage::dcBlocker:        return "dc blocker";
+        case TraceStage::tone:             return "tone";
+        case TraceStage::mix:              return "mix";
+        case TraceStage::output:           return "output";
+        }
+
+        return "unknown";
+    }
+
+    double ticksToMicroseconds(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+}
+
+
+StageTraceWriter::StageTraceWriter(const juce::File& file, const juce::Array<StageTraceRing*>& rings)
+    : juce::Thread("Fuzzer Trace Writer"), _stream(file), _rings(rings), _originTicks(juce::Time::getHighResolutionTicks())
+{
+    if (_stream.openedOk())
+    {
+        _stream.setPosition(0);
+        _stream.truncate();
+        _stream << "{\"traceEvents\":[\n";
+
+        startThread(juce::Thread::Priority::low);
+    }
+}
+
+StageTraceWriter::~StageTraceWriter()
+{
+    stopThread(1000);
+
+    if (! _stream.openedOk())
+        return;
+
+    drain();
+
+    //Events lost to a full ring, as metadata so the trace shows it was incomplete
+    juce::uint32 numDropped = 0;
+
+    for (auto* ring : _rings)
+        numDropped += ring->getNumDropped();
+
+    _stream << "\n],\"otherData\":{\"droppedEvents\":" << juce::String(numDropped) << "}}\n";
+    _stream.flush();
+}
+
+juce::File StageTraceWriter::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getNonexistentChildFile("FuzzerTrace", ".json", false);
+}
+
+void StageTraceWriter::run()
+{
+    while (! threadShouldExit())
+    {
+        drain();
+        wait(_drainIntervalMs);
+    }
+}
+
+//Complete ("X") events in microseconds since the writer started, one track (tid) per engine
+void StageTraceWriter::drain()
+{
+    StageTraceRing::Event event;
+
+    for (int track = 0; track < _rings.size(); ++track)
+    {
+        while (_rings.getUnchecked(track)->pop(event))
+        {
+            if (! _isFirstEvent)
+                _stream << ",\n";
+
+            _isFirstEvent = false;
+
+            _stream << "{\"name\":\"" << getStageName(event.stage) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << juce::String(track)
+                << ",\"ts\":" << juce::String(ticksToMicroseconds(event.startTicks - _originTicks), 3)
+                << ",\"dur\":" << juce::String(ticksToMicroseconds(event.endTicks - event.startTicks), 3) << "}";
+        }
+    }
+
+    _stream.flush();
+}
+
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+
+//Per-stage timing of the Fuzz engine, for offline analysis in a Chrome trace viewer (chrome://tracing, Perfetto)
+//Off by default: build with FUZZER_TRACE_STAGES=1 to enable it. Disabled, FUZZ_TRACE_STAGE expands to nothing
+//and the engine carries no trace state at all
+#ifndef FUZZER_TRACE_STAGES
+ #define FUZZER_TRACE_STAGES 0
+#endif
+
+#if FUZZER_TRACE_STAGES
+
+//Timed stages, in signal order
+enum class TraceStage : juce::uint8
+{
+    drive,
+    oversamplingUp,
+    shaper,
+    oversamplingDown,
+    dcBlocker,
+    tone,
+    mix,
+    output
+};
+
+
+//One engine's events: single producer (the thread running the engine), single consumer (the drain thread)
+//Fixed capacity, never blocks or allocates, and drops events (counting them) when the drain falls behind
+class StageTraceRing
+{
+public:
+
+    struct Event
+    {
+        juce::int64 startTicks = 0;
+        juce::int64 endTicks = 0;
+        TraceStage stage = TraceStage::drive;
+    };
+
+    void push(const Event& event) noexcept
+    {
+        const auto write = _write.load(std::memory_order_relaxed);
+
+        if (write - _read.load(std::memory_order_acquire) == _capacity)
+        {
+            _numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        _events[write & _mask] = event;
+        _write.store(write + 1, std::memory_order_release);
+    }
+
+    bool pop(Event& event) noexcept
+    {
+        const auto read = _read.load(std::memory_order_relaxed);
+
+        if (read == _write.load(std::memory_order_acquire))
+            return false;
+
+        event = _events[read & _mask];
+        _read.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    juce::uint32 getNumDropped() const noexcept { return _numDropped.load(std::memory_order_relaxed); }
+
+private:
+
+    static constexpr juce::uint32 _capacity = 8192;
+    static constexpr juce::uint32 _mask = _capacity - 1;
+
+    std::array<Event, _capacity> _events;
+    std::atomic<juce::uint32> _write{ 0 };
+    std::atomic<juce::uint32> _read{ 0 };
+    std::atomic<juce::uint32> _numDropped{ 0 };
+};
+
+
+//Times its scope into a ring
+class StageTraceZone
+{
+public:
+
+    StageTraceZone(StageTraceRing& ring, TraceStage stage) noexcept
+        : _ring(ring), _stage(stage), _startTicks(juce::Time::getHighResolutionTicks())
+    {
+    }
+
+    ~StageTraceZone()
+    {
+        _ring.push({ _startTicks, juce::Time::getHighResolutionTicks(), _stage });
+    }
+
+private:
+
+    StageTraceRing& _ring;
+    const TraceStage _stage;
+    const juce::int64 _startTicks;
+
+    JUCE_DECLARE_NON_COPYABLE(StageTraceZone)
+};
+
+
+//Background thread that drains a set of rings (one per engine, shown as one track each) into a Chrome trace-event
+//JSON file. The rings must outlive the writer
+class StageTraceWriter : private juce::Thread
+{
+public:
+
+    StageTraceWriter(const juce::File& file, const juce::Array<StageTraceRing*>& rings);
+
+    //Drains what is left and closes the JSON
+    ~StageTraceWriter() override;
+
+    //A new file in the temporary folder for each traced session
+    static juce::File getDefaultFile();
+
+private:
+
+    void run() override;
+    void drain();
+
+    static constexpr int _drainIntervalMs = 20;
+
+    juce::FileOutputStream _stream;
+    juce::Array<StageTraceRing*> _rings;
+    juce::int64 _originTicks = 0;
+    bool _isFirstEvent = true;
+
+    JUCE_DECLARE_NON_COPYABLE(StageTraceWriter)
+};
+
+ #define FUZZ_TRACE_STAGE(ring, stage) const StageTraceZone JUCE_JOIN_MACRO(stageTraceZone, __LINE__)(ring, stage)
+#else
+ #define FUZZ_TRACE_STAGE(ring, stage)
+#endif
@@ -0,0 +1,126 @@
+#include "WorkerPool.h"
+
+
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+
+    explicit Worker(WorkerPool& owner)
+        : juce::Thread("Fuzzer Worker"), _pool(owner)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        _wakeEvent.signal();
+        stopThread(1000);
+    }
+
+    //Only parked workers need the (locking) event, spinning ones see the new batch by themselves
+    void wake() noexcept
+    {
+        if (_isParked.load())
+            _wakeEvent.signal();
+    }
+
+    void run() override
+    {
+        auto seenBatch = _pool.getCurrentBatch();
+
+        while (! threadShouldExit())
+        {
+            auto batch = _pool.getCurrentBatch();
+
+            for (int i = 0; batch == seenBatch && i < _spinIterations; ++i)
+            {
+                juce::Thread::yield();
+                batch = _pool.getCurrentBatch();
+            }
+
+            if (batch == seenBatch)
+            {
+                //Parked flag first, then one more look: run() publishes the batch first, then reads the flag,
+                //so either it signals or this thread sees the batch
+                _isParked.store(true);
+
+                if (_pool.getCurrentBatch() == seenBatch && ! threadShouldExit())
+                    _wakeEvent.wait(-1);
+
+                _isParked.store(false);
+                continue;
+            }
+
+            seenBatch = batch;
+            _pool.processJobs(batch);
+        }
+    }
+
+private:
+
+    WorkerPool& _pool;
+    juce::WaitableEvent _wakeEvent;
+    std::atomic<bool> _isParked{ false };
+};
+
+
+WorkerPool::WorkerPool(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = _workers.add(new Worker(*this));
+        worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    _workers.clear();
+}
+
+juce::uint32 WorkerPool::getCurrentBatch() const noexcept
+{
+    return static_cast<juce::uint32>(_nextJob.load() >> 32);
+}
+
+void WorkerPool::run(Job job, void* context, int numJobs) noexcept
+{
+    _job = job;
+    _context = context;
+    _numJobs.store(numJobs, std::memory_order_relaxed);
+    _numFinished.store(0, std::memory_order_relaxed);
+
+    const auto batch = ++_batch;
+    _nextJob.store(static_cast<juce::uint64>(batch) << 32);
+
+    for (auto* worker : _workers)
+        worker->wake();
+
+    processJobs(batch);
+
+    //Join: every job has finished, including the ones still running on workers
+    while (_numFinished.load(std::memory_order_acquire) < numJobs)
+        juce::Thread::yield();
+}
+
+void WorkerPool::processJobs(juce::uint32 batch) noexcept
+{
+    for (;;)
+    {
+        auto next = _nextJob.load(std::memory_order_acquire);
+
+        if (static_cast<juce::uint32>(next >> 32) != batch)
+            return;
+
+        const auto jobIndex = static_cast<int>(next & 0xffffffffu);
+
+        if (jobIndex >= _numJobs.load(std::memory_order_relaxed))
+            return;
+
+        if (! _nextJob.compare_exchange_weak(next, next + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            continue;
+
+        _job(_context, jobIndex);
+        _numFinished.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+
+//A few pre-spawned threads that share one batch of independent jobs per audio callback with the calling thread
+//Workers spin briefly after a batch and then park on an event. run() takes jobs itself and only returns
+//once every job of the batch has finished, so the caller always sees a complete (deterministic) join
+class WorkerPool
+{
+public:
+
+    using Job = void (*)(void* context, int jobIndex);
+
+    explicit WorkerPool(int numWorkers);
+    ~WorkerPool();
+
+    int getNumWorkers() const noexcept { return _workers.size(); }
+
+    //No allocation or locking, apart from waking workers that have parked
+    void run(Job job, void* context, int numJobs) noexcept;
+
+private:
+
+    class Worker;
+
+    juce::uint32 getCurrentBatch() const noexcept;
+
+    //Claims and runs jobs of one batch until none are left or the batch has moved on
+    void processJobs(juce::uint32 batch) noexcept;
+
+    static constexpr int _spinIterations = 2000;
+
+    juce::OwnedArray<Worker> _workers;
+
+    //Batch number in the high 32 bits, next job index in the low 32 bits: a job is claimed with one
+    //compare-and-swap that fails once the batch has moved on, so a late worker never runs a stale job
+    std::atomic<juce::uint64> _nextJob{ 0 };
+    std::atomic<int> _numJobs{ 0 };
+    std::atomic<int> _numFinished{ 0 };
+
+    //Written by run() before the batch is published, read only after a successful claim
+    Job _job = nullptr;
+    void* _context = nullptr;
+    juce::uint32 _batch = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};
@@ -16,3 +16,24 @@ extern const juce::String mixName		= "Mix";
 
 extern const juce::String toneID		= "tone";
 extern const juce::String toneName		= "Tone";
+
+extern const juce::String oversamplingID			= "oversampling";
+extern const juce::String oversamplingName			= "Oversampling";
+
+extern const juce::String oversamplingFilterID		= "oversamplingFilter";
+extern const juce::String oversamplingFilterName	= "Oversampling Filter";
+
+extern const juce::String shaperID		= "shaper";
+extern const juce::String shaperName	= "Shaper";
+
+extern const juce::String toneSweepID	= "toneSweep";
+extern const juce::String toneSweepName	= "Tone Sweep";
+
+extern const juce::String toneStageID	= "toneStage";
+extern const juce::String toneStageName	= "Tone Stage";
+
+extern const juce::String dcBlockerID	= "dcBlocker";
+extern const juce::String dcBlockerName	= "DC Blocker";
+
+extern const juce::String multicoreID	= "multicore";
+extern const juce::String multicoreName	= "Multicore";
@@ -0,0 +1,23 @@
+#pragma once
+#include <JuceHeader.h>
+
+
+//Every parameter the engine reads, as plain values (choice parameters as their index)
+struct FuzzParameters
+{
+    int model = 0;
+    int tone = 2;
+    int oversampling = 0;
+    int oversamplingFilter = 0;
+    int shaper = 0;
+
+    float drive = 0.0f;
+    float mix = 1.0f;
+    float output = 0.0f;
+    float toneSweep = 0.0f;
+
+    bool toneStage = true;
+    bool dcBlocker = true;
+    bool multicore = false;
+};
+
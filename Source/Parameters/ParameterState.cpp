@@ -0,0 +1,286 @@
+#include "ParameterState.h"
+#include "Parameters.h"
+
+
+namespace
+{
+    //Schema order of the stored values, never reordered (a state written by any version keeps its meaning)
+    const std::array<const juce::String*, ParameterState::_numParameters> schemaParameterIDs
+    {
+        &fuzzModelID,
+        &inputID,
+        &mixID,
+        &outputID,
+        &toneID,
+        &oversamplingID,
+        &oversamplingFilterID,
+        &shaperID,
+        &toneSweepID,
+        &toneStageID,
+        &dcBlockerID,
+        &multicoreID
+    };
+
+    //CRC-32 (IEEE, reflected), the table is built at compile time
+    constexpr std::array<juce::uint32, 256> makeCrcTable()
+    {
+        std::array<juce::uint32, 256> table{};
+
+        for (juce::uint32 i = 0; i < 256; ++i)
+        {
+            auto crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+
+            table[i] = crc;
+        }
+
+        return table;
+    }
+
+    constexpr auto crcTable = makeCrcTable();
+
+    juce::uint32 computeCrc(const juce::uint8* data, size_t numBytes) noexcept
+    {
+        juce::uint32 crc = 0xffffffffu;
+
+        for (size_t i = 0; i < numBytes; ++i)
+            crc = crcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+        return crc ^ 0xffffffffu;
+    }
+
+    //Fixed little-endian layout, whatever the machine that wrote the state
+    void writeUInt16(juce::uint8* dest, juce::uint16 value) noexcept
+    {
+        dest[0] = static_cast<juce::uint8>(value);
+        dest[1] = static_cast<juce::uint8>(value >> 8);
+    }
+
+    void writeUInt32(juce::uint8* dest, juce::uint32 value) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            dest[i] = static_cast<juce::uint8>(value >> (8 * i));
+    }
+
+    void writeFloat(juce::uint8* dest, float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUInt32(dest, bits);
+    }
+
+    float readFloat(const juce::uint8* source) noexcept
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt(source);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    //Snapshot fields in schema order, as the plain values the parameters hold
+    std::array<float, ParameterState::_numParameters> toPlainValues(const FuzzParameters& parameters) noexcept
+    {
+        return
+        {
+            static_cast<float>(parameters.model),
+            parameters.drive,
+            parameters.mix,
+            parameters.output,
+            static_cast<float>(parameters.tone),
+            static_cast<float>(parameters.oversampling),
+            static_cast<float>(parameters.oversamplingFilter),
+            static_cast<float>(parameters.shaper),
+            parameters.toneSweep,
+            parameters.toneStage ? 1.0f : 0.0f,
+            parameters.dcBlocker ? 1.0f : 0.0f,
+            parameters.multicore ? 1.0f : 0.0f
+        };
+    }
+
+    void setSnapshotField(FuzzParameters& parameters, size_t schemaIndex, float value) noexcept
+    {
+        switch (schemaIndex)
+        {
+        case 0: parameters.model = juce::roundToInt(value);
+            break;
+
+        case 1: parameters.drive = value;
+            break;
+
+        case 2: parameters.mix = value;
+            break;
+
+        case 3: parameters.output = value;
+            break;
+
+        case 4: parameters.tone = juce::roundToInt(value);
+            break;
+
+        case 5: parameters.oversampling = juce::roundToInt(value);
+            break;
+
+        case 6: parameters.oversamplingFilter = juce::roundToInt(value);
+            break;
+
+        case 7: parameters.shaper = juce::roundToInt(value);
+            break;
+
+        case 8: parameters.toneSweep = value;
+            break;
+
+        case 9: parameters.toneStage = value >= 0.5f;
+            break;
+
+        case 10: parameters.dcBlocker = value >= 0.5f;
+            break;
+
+        case 11: parameters.multicore = value >= 0.5f;
+            break;
+        }
+    }
+}
+
+
+ParameterState::ParameterState(juce::AudioProcessorValueTreeState& treeState)
+{
+    for (size_t i = 0; i < _parameters.size(); ++i)
+    {
+        _parameters[i] = treeState.getParameter(*schemaParameterIDs[i]);
+        jassert(_parameters[i] != nullptr);
+    }
+}
+
+void ParameterState::write(juce::MemoryBlock& destData, int program) const
+{
+    const auto valuesSize = (_numParameters + _numExtraValues) * sizeof(float);
+    destData.setSize(_headerSize + valuesSize + _checksumSize, false);
+
+    auto* data = static_cast<juce::uint8*>(destData.getData());
+
+    writeUInt32(data, _magic);
+    writeUInt16(data + 4, _schemaVersion);
+    writeUInt16(data + 6, static_cast<juce::uint16>(_numParameters));
+
+    //Plain (denormalised) values, so a later change of a parameter's range doesn't shift stored settings
+    auto* values = data + _headerSize;
+
+    for (auto* parameter : _parameters)
+    {
+        writeFloat(values, parameter->convertFrom0to1(parameter->getValue()));
+        values += sizeof(float);
+    }
+
+    //Exact as a float, like the choice parameters
+    writeFloat(values, static_cast<float>(program));
+    values += sizeof(float);
+
+    writeUInt32(values, computeCrc(data, _headerSize + valuesSize));
+}
+
+const juce::uint8* ParameterState::getValues(const void* data, int sizeInBytes, juce::uint16& version,
+                                             size_t& numParameters, size_t& numExtraValues)
+{
+    if (data == nullptr || sizeInBytes < static_cast<int>(_headerSize + _checksumSize))
+        return nullptr;
+
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+
+    if (juce::ByteOrder::littleEndianInt(bytes) != _magic)
+        return nullptr;
+
+    version = juce::ByteOrder::littleEndianShort(bytes + 4);
+    numParameters = static_cast<size_t>(juce::ByteOrder::littleEndianShort(bytes + 6));
+    const auto payloadSize = static_cast<size_t>(sizeInBytes) - _checksumSize;
+    const auto valuesSize = payloadSize - _headerSize;
+
+    if (version == 0 || valuesSize % sizeof(float) != 0 || valuesSize / sizeof(float) < numParameters)
+        return nullptr;
+
+    numExtraValues = valuesSize / sizeof(float) - numParameters;
+
+    if (juce::ByteOrder::littleEndianInt(bytes + payloadSize) != computeCrc(bytes, payloadSize))
+        return nullptr;
+
+    return bytes + _headerSize;
+}
+
+bool ParameterState::read(const void* data, int sizeInBytes, int& program) const
+{
+    juce::uint16 version = 0;
+    size_t numValues = 0;
+    size_t numExtraValues = 0;
+    const auto* storedValues = getValues(data, sizeInBytes, version, numValues, numExtraValues);
+
+    if (storedValues == nullptr)
+        return false;
+
+    //Version 1 states end with the parameters
+    program = -1;
+
+    if (version >= _programVersion && numExtraValues > 0)
+    {
+        const auto storedProgram = readFloat(storedValues + numValues * sizeof(float));
+
+        if (std::isfinite(storedProgram))
+            program = juce::jmax(-1, juce::roundToInt(storedProgram));
+    }
+
+    //Values the state doesn't have (written before the parameter existed) go back to default
+    PlainValues values;
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = i < numValues ? readFloat(storedValues + i * sizeof(float))
+                                  : _parameters[i]->convertFrom0to1(_parameters[i]->getDefaultValue());
+    }
+
+    setPlainValues(values);
+    return true;
+}
+
+void ParameterState::load(const FuzzParameters& parameters) const
+{
+    setPlainValues(toPlainValues(parameters));
+}
+
+bool ParameterState::decode(const void* data, int sizeInBytes, FuzzParameters& parameters) const
+{
+    juce::uint16 version = 0;
+    size_t numValues = 0;
+    size_t numExtraValues = 0;
+    const auto* storedValues = getValues(data, sizeInBytes, version, numValues, numExtraValues);
+
+    if (storedValues == nullptr)
+        return false;
+
+    //Fields the state doesn't have keep the snapshot's defaults
+    parameters = FuzzParameters();
+
+    for (size_t i = 0; i < juce::jmin(numValues, static_cast<size_t>(_numParameters)); ++i)
+    {
+        const auto value = readFloat(storedValues + i * sizeof(float));
+
+        //Through the parameter's range, as if the value had been set on the parameter itself
+        if (std::isfinite(value))
+            setSnapshotField(parameters, i, _parameters[i]->convertFrom0to1(_parameters[i]->convertTo0to1(value)));
+    }
+
+    return true;
+}
+
+void ParameterState::setPlainValues(const PlainValues& values) const
+{
+    for (size_t i = 0; i < _parameters.size(); ++i)
+    {
+        auto* parameter = _parameters[i];
+        const auto newValue = parameter->convertTo0to1(values[i]);
+
+        //Only changed values notify the host and the listeners
+        if (! std::isfinite(newValue) || newValue == parameter->getValue())
+            continue;
+
+        parameter->setValueNotifyingHost(newValue);
+    }
+}
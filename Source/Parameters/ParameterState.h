@@ -0,0 +1,64 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "ParameterSnapshot.h"
+
+//Readable state: builds with FUZZER_XML_STATE=1 save the session as the APVTS ValueTree XML instead of the binary blob
+//(debugging, diffing or hand editing sessions). Every build loads both
+#ifndef FUZZER_XML_STATE
+ #define FUZZER_XML_STATE 0
+#endif
+
+//Compact binary plugin state: magic, schema version, parameter count, the plain parameter values, the values later
+//schema versions added after them (from version 2, the program index) and a CRC-32
+//The parameters only ever grow at the end, so older states restore the values they have and leave the rest at default,
+//and newer ones restore the values this version knows about. The values after them are found past the stored
+//parameter count, so they keep their meaning whatever number of parameters the writer had
+//Restoring pushes the values straight into the parameters, with no ValueTree, XML parsing or allocation on the way
+class ParameterState
+{
+public:
+
+    explicit ParameterState(juce::AudioProcessorValueTreeState& treeState);
+
+    //The program is the host's current program, or -1 for none (preset files)
+    void write(juce::MemoryBlock& destData, int program) const;
+
+    //Returns false, leaving every parameter untouched, when the data is not an intact binary state
+    //The stored program comes back in program, -1 when the state has none
+    bool read(const void* data, int sizeInBytes, int& program) const;
+
+    //Pushes a whole snapshot into the parameters (presets), only the changed values notify
+    void load(const FuzzParameters& parameters) const;
+
+    //Reads a binary state (e.g. a preset file) into a snapshot, within the parameter ranges, without touching any parameter
+    bool decode(const void* data, int sizeInBytes, FuzzParameters& parameters) const;
+
+    //Parameters in schema order (append new ones at the end and bump _schemaVersion)
+    static constexpr int _numParameters = 12;
+
+private:
+
+    static constexpr juce::uint32 _magic = 0x54535a46; //"FZST" read as little-endian
+    static constexpr juce::uint16 _schemaVersion = 2;
+
+    //Values after the parameters, in the order the schema versions added them
+    static constexpr juce::uint16 _programVersion = 2;
+    static constexpr size_t _numExtraValues = 1;
+
+    static constexpr size_t _headerSize = sizeof(juce::uint32) + 2 * sizeof(juce::uint16);
+    static constexpr size_t _checksumSize = sizeof(juce::uint32);
+
+    //Checks magic, size and CRC, returns the stored values (little-endian floats) or nullptr
+    //The parameters come first, numExtraValues values follow them
+    static const juce::uint8* getValues(const void* data, int sizeInBytes, juce::uint16& version,
+                                        size_t& numParameters, size_t& numExtraValues);
+
+    using PlainValues = std::array<float, _numParameters>;
+
+    void setPlainValues(const PlainValues& values) const;
+
+    std::array<juce::RangedAudioParameter*, _numParameters> _parameters{};
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterState)
+};
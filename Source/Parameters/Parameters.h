@@ -17,4 +17,25 @@ extern const juce::String mixName;
 extern const juce::String toneID;
 extern const juce::String toneName;
 
+extern const juce::String oversamplingID;
+extern const juce::String oversamplingName;
+
+extern const juce::String oversamplingFilterID;
+extern const juce::String oversamplingFilterName;
+
+extern const juce::String shaperID;
+extern const juce::String shaperName;
+
+extern const juce::String toneSweepID;
+extern const juce::String toneSweepName;
+
+extern const juce::String toneStageID;
+extern const juce::String toneStageName;
+
+extern const juce::String dcBlockerID;
+extern const juce::String dcBlockerName;
+
+extern const juce::String multicoreID;
+extern const juce::String multicoreName;
+
 
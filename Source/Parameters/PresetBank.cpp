@@ -0,0 +1,176 @@
+#include "PresetBank.h"
+
+
+namespace
+{
+    const juce::String presetFileExtension = ".fzpreset";
+
+    //Choice parameters as their index (model: Hard, Redux, Fat / tone: Brightest ... Darkest / shaper: Analytic, ADAA 1st, ADAA 2nd, Lookup Table)
+    FuzzParameters makePreset(int model, int tone, int oversampling, int oversamplingFilter, int shaper,
+        float drive, float mix, float output, float toneSweep)
+    {
+        FuzzParameters parameters;
+
+        parameters.model = model;
+        parameters.tone = tone;
+        parameters.oversampling = oversampling;
+        parameters.oversamplingFilter = oversamplingFilter;
+        parameters.shaper = shaper;
+
+        parameters.drive = drive;
+        parameters.mix = mix;
+        parameters.output = output;
+        parameters.toneSweep = toneSweep;
+
+        return parameters;
+    }
+
+    struct FactoryPreset
+    {
+        const char* name;
+        FuzzParameters parameters;
+    };
+
+    const FactoryPreset factoryPresets[] =
+    {
+        { "Init",            makePreset(0, 2, 0, 0, 0,  0.0f, 1.0f,   0.0f,  0.0f) },
+        { "Warm Crunch",     makePreset(2, 3, 1, 0, 1,  9.0f, 1.0f,  -3.0f, -0.2f) },
+        { "Hard Drive",      makePreset(0, 2, 1, 0, 2, 18.0f, 1.0f,  -8.0f,  0.0f) },
+        { "Redux Buzz",      makePreset(1, 1, 0, 0, 0, 15.0f, 1.0f,  -6.0f,  0.3f) },
+        { "Fat Wall",        makePreset(2, 4, 2, 0, 0, 24.0f, 1.0f, -10.0f, -0.4f) },
+        { "Parallel Grit",   makePreset(0, 2, 1, 0, 1, 20.0f, 0.35f, -2.0f,  0.0f) },
+        { "Bright Fizz",     makePreset(1, 0, 1, 0, 1, 21.0f, 1.0f,  -9.0f,  0.6f) },
+        { "Linear Phase",    makePreset(0, 2, 2, 1, 0, 12.0f, 1.0f,  -5.0f,  0.0f) }
+    };
+}
+
+
+PresetBank::PresetBank()
+{
+    for (const auto& preset : factoryPresets)
+        append(preset.name, preset.parameters);
+
+    _numFactoryPresets = getNumPresets();
+}
+
+int PresetBank::getNumPresets() const noexcept
+{
+    return _numPresets.load(std::memory_order_acquire);
+}
+
+const FuzzParameters& PresetBank::getParameters(int index) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, getNumPresets()));
+    return _presets[static_cast<size_t>(index)].parameters;
+}
+
+const juce::String& PresetBank::getName(int index) const noexcept
+{
+    static const juce::String noName;
+    return juce::isPositiveAndBelow(index, getNumPresets()) ? _presets[static_cast<size_t>(index)].name : noName;
+}
+
+bool PresetBank::renameUserPreset(int index, const juce::String& newName)
+{
+    const juce::ScopedLock sl(_writeLock);
+
+    const auto userIndex = index - _numFactoryPresets;
+
+    if (! juce::isPositiveAndBelow(userIndex, _userPresetFiles.size()) || newName.trim().isEmpty())
+        return false;
+
+    const auto file = _userPresetFiles.getReference(userIndex);
+    const auto legalName = juce::File::createLegalFileName(newName.trim());
+
+    if (legalName == file.getFileNameWithoutExtension())
+        return true;
+
+    const auto newFile = file.getParentDirectory().getNonexistentChildFile(legalName, presetFileExtension, false);
+
+    if (! file.moveFileTo(newFile))
+        return false;
+
+    _userPresetFiles.set(userIndex, newFile);
+    _presets[static_cast<size_t>(index)].name = newFile.getFileNameWithoutExtension();
+
+    return true;
+}
+
+void PresetBank::loadUserPresets(const ParameterState& parameterState)
+{
+    const juce::ScopedLock sl(_writeLock);
+
+    if (_hasLoadedUserPresets)
+        return;
+
+    _hasLoadedUserPresets = true;
+    scanUserPresets(parameterState);
+}
+
+int PresetBank::addUserPreset(const juce::String& name, const juce::MemoryBlock& state, const ParameterState& parameterState)
+{
+    const juce::ScopedLock sl(_writeLock);
+
+    FuzzParameters parameters;
+
+    if (getNumPresets() >= _maxNumPresets || ! parameterState.decode(state.getData(), static_cast<int>(state.getSize()), parameters))
+        return -1;
+
+    const auto directory = getUserPresetDirectory();
+    const auto file = directory.getNonexistentChildFile(juce::File::createLegalFileName(name), presetFileExtension, false);
+
+    if (! directory.createDirectory() || ! file.replaceWithData(state.getData(), state.getSize()))
+        return -1;
+
+    _hasLoadedUserPresets = true;
+    scanUserPresets(parameterState);
+
+    const auto userIndex = _userPresetFiles.indexOf(file);
+    return userIndex < 0 ? -1 : _numFactoryPresets + userIndex;
+}
+
+juce::File PresetBank::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile(JucePlugin_Manufacturer)
+        .getChildFile(JucePlugin_Name)
+        .getChildFile("Presets");
+}
+
+void PresetBank::scanUserPresets(const ParameterState& parameterState)
+{
+    auto files = getUserPresetDirectory().findChildFiles(juce::File::findFiles, false, "*" + presetFileExtension);
+    files.sort();
+
+    //Files that aren't intact binary states are left out
+    for (const auto& file : files)
+    {
+        if (_userPresetFiles.contains(file))
+            continue;
+
+        juce::MemoryBlock state;
+        FuzzParameters parameters;
+
+        if (file.loadFileAsData(state) && parameterState.decode(state.getData(), static_cast<int>(state.getSize()), parameters))
+        {
+            if (append(file.getFileNameWithoutExtension(), parameters) < 0)
+                break;
+
+            _userPresetFiles.add(file);
+        }
+    }
+}
+
+int PresetBank::append(const juce::String& name, const FuzzParameters& parameters)
+{
+    const auto index = getNumPresets();
+
+    if (index >= _maxNumPresets)
+        return -1;
+
+    //Written before the count is published, so a reader never sees a half-written entry
+    _presets[static_cast<size_t>(index)] = { name, parameters };
+    _numPresets.store(index + 1, std::memory_order_release);
+
+    return index;
+}
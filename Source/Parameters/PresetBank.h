@@ -0,0 +1,69 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "ParameterSnapshot.h"
+#include "ParameterState.h"
+
+
+//Factory presets followed by the user's preset files, in a flat array of snapshots
+//One bank is shared by every instance in the process (through juce::SharedResourcePointer), so the preset folder is
+//read once and a preset saved in one instance shows up in all of them
+//Entries are only ever appended (a saved user preset) and their snapshots never moved or rewritten, and the count is
+//published last, so the audio thread reads any entry below getNumPresets() with no lock, allocation or file I/O.
+//Writers share a lock, names (renamed user presets) are only read on the message thread
+class PresetBank
+{
+public:
+
+    PresetBank();
+
+    int getNumPresets() const noexcept;
+    int getNumFactoryPresets() const noexcept { return _numFactoryPresets; }
+
+    //Any thread
+    const FuzzParameters& getParameters(int index) const noexcept;
+
+    //Message thread only
+    const juce::String& getName(int index) const noexcept;
+
+    //Renames a user preset's file and entry, returns false for factory presets or when the file can't be moved
+    //The name becomes the new file's name, as when the folder is read
+    bool renameUserPreset(int index, const juce::String& newName);
+
+    //Reads the preset folder the first time any instance asks, later calls return at once
+    //The parameter state only decodes the files (the layout is the same in every instance, any one will do)
+    void loadUserPresets(const ParameterState& parameterState);
+
+    //Writes a binary state as a preset file, then appends every preset file not in the bank yet (other processes may
+    //have saved some too). Returns the new preset's index (-1 when full or not written)
+    int addUserPreset(const juce::String& name, const juce::MemoryBlock& state, const ParameterState& parameterState);
+
+    static juce::File getUserPresetDirectory();
+
+    static constexpr int _maxNumPresets = 128;
+
+private:
+
+    struct Preset
+    {
+        juce::String name;
+        FuzzParameters parameters;
+    };
+
+    //Appends the preset files that aren't in the bank yet, in file name order, with the lock held
+    void scanUserPresets(const ParameterState& parameterState);
+
+    int append(const juce::String& name, const FuzzParameters& parameters);
+
+    std::array<Preset, _maxNumPresets> _presets;
+    std::atomic<int> _numPresets{ 0 };
+    int _numFactoryPresets = 0;
+
+    //User presets, in bank order after the factory ones
+    juce::Array<juce::File> _userPresetFiles;
+    bool _hasLoadedUserPresets = false;
+    juce::CriticalSection _writeLock;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
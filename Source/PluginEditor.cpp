@@ -112,6 +112,124 @@ FuzzerAudioProcessorEditor::FuzzerAudioProcessorEditor(FuzzerAudioProcessor& p)
 
 
 
+    //toneSweepSlider
+    toneSweepSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor._treeState, "toneSweep", toneSweepSlider);
+
+    toneSweepSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    toneSweepSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 48, 20);
+    toneSweepSlider.setRange(-1.0f, 1.0f, 0.01f);
+    toneSweepSlider.setDoubleClickReturnValue(true, 0.0f);
+    addAndMakeVisible(toneSweepSlider);
+
+    //toneSweepLabel
+    addAndMakeVisible(toneSweepLabel);
+    toneSweepLabel.setText("Sweep", juce::dontSendNotification);
+    toneSweepLabel.attachToComponent(&toneSweepSlider, true);
+    toneSweepLabel.setJustificationType(juce::Justification::centredRight);
+
+    //toneStageToggle
+    toneStageAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor._treeState, "toneStage", toneStageToggle);
+
+    toneStageToggle.setButtonText("Tone");
+    addAndMakeVisible(toneStageToggle);
+
+    //dcBlockerToggle
+    dcBlockerAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor._treeState, "dcBlocker", dcBlockerToggle);
+
+    dcBlockerToggle.setButtonText("DC");
+    addAndMakeVisible(dcBlockerToggle);
+
+    //multicoreToggle
+    multicoreAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor._treeState, "multicore", multicoreToggle);
+
+    multicoreToggle.setButtonText("Multicore");
+    addAndMakeVisible(multicoreToggle);
+
+
+
+    //oversampling
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor._treeState, "oversampling", oversampling);
+
+    addAndMakeVisible(oversampling);
+    oversampling.setTextWhenNothingSelected("1x");
+    oversampling.addItem("1x", 1);
+    oversampling.addItem("2x", 2);
+    oversampling.addItem("4x", 3);
+    oversampling.addItem("8x", 4);
+
+    oversampling.onChange = [this]() { syncMenuWithParameter(oversampling, "oversampling"); };
+
+    //oversamplingLabel
+    addAndMakeVisible(oversamplingLabel);
+    oversamplingLabel.setText("Oversampling", juce::dontSendNotification);
+    oversamplingLabel.attachToComponent(&oversampling, false);
+    oversamplingLabel.setJustificationType(juce::Justification::centred);
+
+    //oversamplingFilter
+    oversamplingFilterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor._treeState, "oversamplingFilter", oversamplingFilter);
+
+    addAndMakeVisible(oversamplingFilter);
+    oversamplingFilter.setTextWhenNothingSelected("Polyphase IIR");
+    oversamplingFilter.addItem("Polyphase IIR", 1);
+    oversamplingFilter.addItem("FIR Equiripple", 2);
+
+    oversamplingFilter.onChange = [this]() { syncMenuWithParameter(oversamplingFilter, "oversamplingFilter"); };
+
+
+
+    //shaper
+    shaperAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor._treeState, "shaper", shaper);
+
+    addAndMakeVisible(shaper);
+    shaper.setTextWhenNothingSelected("Analytic");
+    shaper.addItem("Analytic", 1);
+    shaper.addItem("ADAA 1st Order", 2);
+    shaper.addItem("ADAA 2nd Order", 3);
+    shaper.addItem("Lookup Table", 4);
+
+    shaper.onChange = [this]() { syncMenuWithParameter(shaper, "shaper"); };
+
+    //shaperLabel
+    addAndMakeVisible(shaperLabel);
+    shaperLabel.setText("Shaper", juce::dontSendNotification);
+    shaperLabel.attachToComponent(&shaper, false);
+    shaperLabel.setJustificationType(juce::Justification::centred);
+
+
+
+
+
+    //presets (factory presets, then the user's, in the host's program list order)
+    addAndMakeVisible(presets);
+    presets.setTextWhenNothingSelected("Presets");
+    refreshPresetMenu();
+
+    presets.onChange = [this]()
+        {
+            if (presets.getSelectedId() > 0)
+                audioProcessor.setCurrentProgram(presets.getSelectedId() - 1);
+        };
+
+    //savePresetButton
+    addAndMakeVisible(savePresetButton);
+    savePresetButton.setButtonText("Save");
+
+    savePresetButton.onClick = [this]()
+        {
+            const auto userNumber = audioProcessor.getNumPrograms() - audioProcessor.getNumFactoryPrograms() + 1;
+
+            if (audioProcessor.saveUserPreset("User " + juce::String(userNumber)) >= 0)
+                refreshPresetMenu();
+        };
+
+
+
+    //cpuLoadLabel (this instance's load, its peak and the blocks that came close to an overrun)
+    addAndMakeVisible(cpuLoadLabel);
+    cpuLoadLabel.setFont(juce::FontOptions(12.0f));
+    cpuLoadLabel.setColour(juce::Label::textColourId, juce::Colours::whitesmoke.withAlpha(0.6f));
+    cpuLoadLabel.setJustificationType(juce::Justification::centredLeft);
+
 
 
     //button
@@ -142,10 +260,15 @@ FuzzerAudioProcessorEditor::FuzzerAudioProcessorEditor(FuzzerAudioProcessor& p)
     // Sync ComboBoxes
     syncMenuWithParameter(menu, "fuzzModel");
     syncMenuWithParameter(tone, "tone");
+    syncMenuWithParameter(oversampling, "oversampling");
+    syncMenuWithParameter(oversamplingFilter, "oversamplingFilter");
+    syncMenuWithParameter(shaper, "shaper");
 
     initWindow();
 
     setSize(700, 500);
+
+    startTimerHz(4);
 }
 
 FuzzerAudioProcessorEditor::~FuzzerAudioProcessorEditor()
@@ -171,8 +294,6 @@ void FuzzerAudioProcessorEditor::resized()
     auto buttonWidth = dialSize * 0.35;
     auto buttonHeight = buttonWidth * 0.5;
 
-    auto toggleSize = getWidth() * 0.3;
-
     inputSlider.setBounds(leftMargin, topMargin, dialSize, dialSize); 
     outputSlider.setBounds(leftMargin * 32.0f, topMargin, dialSize, dialSize);
     mixSlider.setBounds(leftMargin * 16.0f, topMargin * 3.0f, dialSize, dialSize / 2.0f);
@@ -182,6 +303,23 @@ void FuzzerAudioProcessorEditor::resized()
     tone.setBounds(inputSlider.getX() + inputSlider.getWidth() - ((inputSlider.getX() + inputSlider.getWidth()) / 1.7f),
         topMargin * 5.6f, buttonWidth * 6.5f, buttonHeight * 2.0f);
 
+    //Sweep and stage toggles sit above the tone label, inside the window
+    toneSweepSlider.setBounds(tone.getX(), tone.getY() - buttonHeight * 2.0f, tone.getWidth() * 0.6f, buttonHeight);
+    toneStageToggle.setBounds(toneSweepSlider.getRight(), toneSweepSlider.getY(), tone.getWidth() * 0.2f, buttonHeight);
+    dcBlockerToggle.setBounds(toneStageToggle.getRight(), toneSweepSlider.getY(), tone.getWidth() * 0.2f, buttonHeight);
+
+    oversampling.setBounds(menu.getX(), menu.getBottom() + buttonHeight, menu.getWidth(), menu.getHeight());
+    oversamplingFilter.setBounds(menu.getX(), oversampling.getBottom(), menu.getWidth(), menu.getHeight());
+    shaper.setBounds(menu.getX(), oversamplingFilter.getBottom() + buttonHeight, menu.getWidth(), menu.getHeight());
+    multicoreToggle.setBounds(shaper.getRight() + leftMargin, outputSlider.getBottom(), shaper.getWidth(), buttonHeight);
+
+    //Load readout in the strip under the tone menu
+    cpuLoadLabel.setBounds(leftMargin, tone.getBottom(), dialSize * 1.2f, getHeight() - tone.getBottom());
+
+    //Presets in the top corners, either side of the title
+    presets.setBounds(leftMargin, leftMargin, dialSize * 0.8f, buttonHeight);
+    savePresetButton.setBounds(getWidth() - leftMargin - buttonWidth, leftMargin, buttonWidth, buttonHeight);
+
     //button.setBounds(inputSlider.getX() + inputSlider.getWidth() * 0.33, inputSlider.getY() + inputSlider.getHeight(), 
         //buttonWidth, buttonHeight);
     //toggle.setBounds(button.getX(), button.getY() + button.getHeight() + 12, toggleSize, toggleSize);
@@ -189,6 +327,35 @@ void FuzzerAudioProcessorEditor::resized()
 }
 
 
+void FuzzerAudioProcessorEditor::timerCallback()
+{
+    //Programs changed by the host or MIDI, and presets saved by another instance (the bank is shared)
+    if (presets.getNumItems() != audioProcessor.getNumPrograms() || presets.getSelectedId() != audioProcessor.getCurrentProgram() + 1)
+        refreshPresetMenu();
+
+    cpuLoadLabel.setText("CPU " + juce::String(audioProcessor.getCpuLoad() * 100.0f, 1) + "%  peak "
+        + juce::String(audioProcessor.getPeakCpuLoad() * 100.0f, 1) + "%  risk " + juce::String(audioProcessor.getXrunRiskCount()),
+        juce::dontSendNotification);
+}
+
+
+// Rebuilds the preset menu from the processor's programs and selects the current one
+void FuzzerAudioProcessorEditor::refreshPresetMenu()
+{
+    presets.clear(juce::dontSendNotification);
+
+    for (int i = 0; i < audioProcessor.getNumPrograms(); ++i)
+    {
+        if (i == audioProcessor.getNumFactoryPrograms())
+            presets.addSeparator();
+
+        presets.addItem(audioProcessor.getProgramName(i), i + 1);
+    }
+
+    presets.setSelectedId(audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
+}
+
+
 // Sync ComboBox with Parameter
 void FuzzerAudioProcessorEditor::syncMenuWithParameter(juce::ComboBox& comboBox, const juce::String& parameterID)
 {
@@ -7,7 +7,7 @@
 //==============================================================================
 /**
 */
-class FuzzerAudioProcessorEditor : public juce::AudioProcessorEditor
+class FuzzerAudioProcessorEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     FuzzerAudioProcessorEditor(FuzzerAudioProcessor&);
@@ -24,19 +24,37 @@ private:
 
     void initWindow();
 
+    //Refreshes the CPU load readout, and the preset menu when the programs changed
+    void timerCallback() override;
+
     juce::Slider inputSlider;
     juce::Slider outputSlider;
     juce::Slider mixSlider;
+    juce::Slider toneSweepSlider;
 
     juce::Label inputLabel;
     juce::Label outputLabel;
     juce::Label mixLabel;
+    juce::Label toneSweepLabel;
+    juce::Label cpuLoadLabel;
+
+    juce::ToggleButton toneStageToggle;
+    juce::ToggleButton dcBlockerToggle;
+    juce::ToggleButton multicoreToggle;
 
     juce::ComboBox menu;
     juce::ComboBox tone;
+    juce::ComboBox oversampling;
+    juce::ComboBox oversamplingFilter;
+    juce::ComboBox shaper;
+    juce::ComboBox presets;
+
+    juce::TextButton savePresetButton;
 
     juce::Label menuLabel;
     juce::Label toneLabel;
+    juce::Label oversamplingLabel;
+    juce::Label shaperLabel;
 
     //juce::TextButton button;
 
@@ -48,12 +66,22 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> inputSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> outputSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> toneSweepSliderAttachment;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> menuAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> toneAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingFilterAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> shaperAttachment;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> toneStageAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> dcBlockerAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> multicoreAttachment;
+
 
+    void refreshPresetMenu();
 
-    void FuzzerAudioProcessorEditor::syncMenuWithParameter(juce::ComboBox& comboBox, const juce::String& parameterID);
+    void syncMenuWithParameter(juce::ComboBox& comboBox, const juce::String& parameterID);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FuzzerAudioProcessorEditor)
 };
@@ -16,22 +16,59 @@ FuzzerAudioProcessor::FuzzerAudioProcessor()
     )
     , _treeState(*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
+    , _parameterState(_treeState)
 {
+    _presetBank->loadUserPresets(_parameterState);
+
     _treeState.addParameterListener(fuzzModelID, this);
     _treeState.addParameterListener(inputID, this);
     _treeState.addParameterListener(mixID, this);
     _treeState.addParameterListener(outputID, this);
     _treeState.addParameterListener(toneID, this);
+    _treeState.addParameterListener(oversamplingID, this);
+    _treeState.addParameterListener(oversamplingFilterID, this);
+    _treeState.addParameterListener(shaperID, this);
+    _treeState.addParameterListener(toneSweepID, this);
+    _treeState.addParameterListener(toneStageID, this);
+    _treeState.addParameterListener(dcBlockerID, this);
+    _treeState.addParameterListener(multicoreID, this);
+
+    _parameterValues.model = _treeState.getRawParameterValue(fuzzModelID);
+    _parameterValues.tone = _treeState.getRawParameterValue(toneID);
+    _parameterValues.oversampling = _treeState.getRawParameterValue(oversamplingID);
+    _parameterValues.oversamplingFilter = _treeState.getRawParameterValue(oversamplingFilterID);
+    _parameterValues.shaper = _treeState.getRawParameterValue(shaperID);
+    _parameterValues.drive = _treeState.getRawParameterValue(inputID);
+    _parameterValues.mix = _treeState.getRawParameterValue(mixID);
+    _parameterValues.output = _treeState.getRawParameterValue(outputID);
+    _parameterValues.toneSweep = _treeState.getRawParameterValue(toneSweepID);
+    _parameterValues.toneStage = _treeState.getRawParameterValue(toneStageID);
+    _parameterValues.dcBlocker = _treeState.getRawParameterValue(dcBlockerID);
+    _parameterValues.multicore = _treeState.getRawParameterValue(multicoreID);
+
+    _fuzzModules.add(new Fuzz<float>());
+    _fuzzModulesDouble.add(new Fuzz<double>());
+
+    startTimer(_messagePollIntervalMs);
 }
 
 //Destructor
 FuzzerAudioProcessor::~FuzzerAudioProcessor()
 {
+    stopTimer();
+
     _treeState.removeParameterListener(fuzzModelID, this);
     _treeState.removeParameterListener(inputID, this);
     _treeState.removeParameterListener(mixID, this);
     _treeState.removeParameterListener(outputID, this);
     _treeState.removeParameterListener(toneID, this);
+    _treeState.removeParameterListener(oversamplingID, this);
+    _treeState.removeParameterListener(oversamplingFilterID, this);
+    _treeState.removeParameterListener(shaperID, this);
+    _treeState.removeParameterListener(toneSweepID, this);
+    _treeState.removeParameterListener(toneStageID, this);
+    _treeState.removeParameterListener(dcBlockerID, this);
+    _treeState.removeParameterListener(multicoreID, this);
 }
 
 
@@ -47,6 +84,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout FuzzerAudioProcessor::create
 
     juce::StringArray toneCharacters = { "Brightest", "Brighter", "Normal", "Darker", "Darkest"};
 
+    juce::StringArray oversamplingFactors = { "1x", "2x", "4x", "8x" };
+
+    juce::StringArray oversamplingFilters = { "Polyphase IIR", "FIR Equiripple" };
+
+    juce::StringArray shaperModes = { "Analytic", "ADAA 1st Order", "ADAA 2nd Order", "Lookup Table" };
+
 
     //Fuzz Model Selector
     auto pFuzzModel = std::make_unique<juce::AudioParameterChoice>(fuzzModelID, fuzzModelName, fuzzModels, 0);
@@ -64,64 +107,216 @@ juce::AudioProcessorValueTreeState::ParameterLayout FuzzerAudioProcessor::create
     //Tone
     auto pToneCharacter = std::make_unique<juce::AudioParameterChoice>(toneID, toneName, toneCharacters, 2);
 
+    //Tone Sweep (continuous, on top of the character: darker below 0, brighter above)
+    auto pToneSweep = std::make_unique<juce::AudioParameterFloat>(toneSweepID, toneSweepName, -1.0f, 1.0f, 0.0f);
+
+    //Filter stages (off leaves them out of the signal path, e.g. when EQ is done elsewhere)
+    auto pToneStage = std::make_unique<juce::AudioParameterBool>(toneStageID, toneStageName, true);
+    auto pDcBlocker = std::make_unique<juce::AudioParameterBool>(dcBlockerID, dcBlockerName, true);
+
+    //Multicore (spreads the channel groups of wide buses over worker threads, a setting rather than something to automate)
+    auto pMulticore = std::make_unique<juce::AudioParameterBool>(multicoreID, multicoreName, false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false));
+
+    //Oversampling (factor, and low latency IIR or linear phase FIR filters)
+    auto pOversampling = std::make_unique<juce::AudioParameterChoice>(oversamplingID, oversamplingName, oversamplingFactors, 0);
+    auto pOversamplingFilter = std::make_unique<juce::AudioParameterChoice>(oversamplingFilterID, oversamplingFilterName, oversamplingFilters, 0);
+
+    //Shaper (antiderivative anti-aliasing, a cheaper alternative to oversampling)
+    auto pShaper = std::make_unique<juce::AudioParameterChoice>(shaperID, shaperName, shaperModes, 0);
+
     params.push_back(std::move(pFuzzModel));
     params.push_back(std::move(pDrive));
     params.push_back(std::move(pMix));
     params.push_back(std::move(pOutput));
     params.push_back(std::move(pToneCharacter));
+    params.push_back(std::move(pOversampling));
+    params.push_back(std::move(pOversamplingFilter));
+    params.push_back(std::move(pShaper));
+    params.push_back(std::move(pToneSweep));
+    params.push_back(std::move(pToneStage));
+    params.push_back(std::move(pDcBlocker));
+    params.push_back(std::move(pMulticore));
 
     return { params.begin(), params.end() };
 }
 
 //==============================================================================
 
-void FuzzerAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+void FuzzerAudioProcessor::parameterChanged(const juce::String& parameterID, float)
 {
-    updateParameters(); // Update other parameters
+    // Can run on the audio thread (host automation), so it only raises flags
+    _parametersChanged.store(true, std::memory_order_release);
+
+    if (parameterID == oversamplingID || parameterID == oversamplingFilterID)
+        _latencyChanged.store(true, std::memory_order_release);
+}
+
+void FuzzerAudioProcessor::timerCallback()
+{
+    // The parameters follow a program change the audio thread has already swapped in. Until they hold it,
+    // readParameters gives the audio thread the preset, so flags raised meanwhile (by the load itself, automation
+    // or the UI) never take it back to the old values. A program set while loading stays for the next tick
+    auto program = _programToLoad.load(std::memory_order_acquire);
+
+    if (program >= 0)
+    {
+        _parameterState.load(getProgramParameters(program));
+        _programToLoad.compare_exchange_strong(program, -1, std::memory_order_acq_rel);
+
+        _parametersChanged.store(true, std::memory_order_release);
+        _latencyChanged.store(true, std::memory_order_release);
+
+        // MIDI program changes reach the host's program list here (the wrappers skip a program the host already shows)
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    }
+
+    if (_latencyChanged.exchange(false, std::memory_order_acquire))
+        setLatencySamples(getFuzzLatencyInSamples(readParameters()));
+
+    // The tail follows tone, bypass and oversampling. ChangeDetails has no tail flag,
+    // the latency one is the nearest the wrappers pass on (VST3 hosts read the tail when they activate the plugin)
+    const auto tailLength = getTailLengthSeconds();
+
+    if (tailLength != _reportedTailLength)
+    {
+        _reportedTailLength = tailLength;
+        updateHostDisplay(ChangeDetails().withLatencyChanged(true));
+    }
+}
+
+int FuzzerAudioProcessor::getFuzzLatencyInSamples(const FuzzParameters& parameters) const noexcept
+{
+    return isUsingDoublePrecision()
+        ? _fuzzModulesDouble.getUnchecked(0)->getLatencyInSamples(parameters.oversampling, static_cast<Fuzz<double>::OversamplingFilter>(parameters.oversamplingFilter))
+        : _fuzzModules.getUnchecked(0)->getLatencyInSamples(parameters.oversampling, static_cast<Fuzz<float>::OversamplingFilter>(parameters.oversamplingFilter));
 }
 
 
 
 //==============================================================================
 
-void FuzzerAudioProcessor::updateParameters()
+FuzzParameters FuzzerAudioProcessor::readParameters() const noexcept
 {
-    auto model = static_cast<int>(_treeState.getRawParameterValue(fuzzModelID)->load());
-    switch (model)
+    // A program the parameters don't hold yet stands in for them
+    const auto program = _programToLoad.load(std::memory_order_acquire);
+
+    if (program >= 0)
+        return getProgramParameters(program);
+
+    FuzzParameters parameters;
+
+    parameters.model = static_cast<int>(_parameterValues.model->load());
+    parameters.tone = static_cast<int>(_parameterValues.tone->load());
+    parameters.oversampling = static_cast<int>(_parameterValues.oversampling->load());
+    parameters.oversamplingFilter = static_cast<int>(_parameterValues.oversamplingFilter->load());
+    parameters.shaper = static_cast<int>(_parameterValues.shaper->load());
+
+    parameters.drive = _parameterValues.drive->load();
+    parameters.mix = _parameterValues.mix->load();
+    parameters.output = _parameterValues.output->load();
+    parameters.toneSweep = _parameterValues.toneSweep->load();
+
+    parameters.toneStage = _parameterValues.toneStage->load() >= 0.5f;
+    parameters.dcBlocker = _parameterValues.dcBlocker->load() >= 0.5f;
+    parameters.multicore = _parameterValues.multicore->load() >= 0.5f;
+
+    return parameters;
+}
+
+FuzzParameters FuzzerAudioProcessor::getProgramParameters(int index) const noexcept
+{
+    auto parameters = _presetBank->getParameters(index);
+    parameters.multicore = _parameterValues.multicore->load() >= 0.5f;
+
+    return parameters;
+}
+
+template <typename SampleType>
+void FuzzerAudioProcessor::applyParameters(Fuzz<SampleType>& fuzzModule, const FuzzParameters& parameters, bool applyAll)
+{
+    using FuzzType = Fuzz<SampleType>;
+
+    const auto& applied = _appliedParameters;
+
+    if (applyAll || parameters.model != applied.model)
     {
-    case 0: _fuzzModule.setFuzzModel(Fuzz<float>::FuzzModel::kHard);
-        break;
+        switch (parameters.model)
+        {
+        case 0: fuzzModule.setFuzzModel(FuzzType::FuzzModel::kHard);
+            break;
 
-    case 1: _fuzzModule.setFuzzModel(Fuzz<float>::FuzzModel::kRedux);
-        break;
+        case 1: fuzzModule.setFuzzModel(FuzzType::FuzzModel::kRedux);
+            break;
 
-    case 2: _fuzzModule.setFuzzModel(Fuzz<float>::FuzzModel::kFat);
-        break;
+        case 2: fuzzModule.setFuzzModel(FuzzType::FuzzModel::kFat);
+            break;
+        }
     }
 
-    auto tCharacter = static_cast<int>(_treeState.getRawParameterValue(toneID)->load());
-    switch (tCharacter)
+    // Tone coefficients are only recomputed here, on the audio thread, and only when the tone changes
+    if (applyAll || parameters.tone != applied.tone)
     {
-    case 0: _fuzzModule.setToneCharacter(Fuzz<float>::ToneCharacter::brightest);
-        break;
+        switch (parameters.tone)
+        {
+        case 0: fuzzModule.setToneCharacter(FuzzType::ToneCharacter::brightest);
+            break;
 
-    case 1: _fuzzModule.setToneCharacter(Fuzz<float>::ToneCharacter::brighter);
-        break;
+        case 1: fuzzModule.setToneCharacter(FuzzType::ToneCharacter::brighter);
+            break;
 
-    case 2: _fuzzModule.setToneCharacter(Fuzz<float>::ToneCharacter::normal);
-        break;
+        case 2: fuzzModule.setToneCharacter(FuzzType::ToneCharacter::normal);
+            break;
 
-    case 3: _fuzzModule.setToneCharacter(Fuzz<float>::ToneCharacter::darker);
-        break;
+        case 3: fuzzModule.setToneCharacter(FuzzType::ToneCharacter::darker);
+            break;
+
+        case 4: fuzzModule.setToneCharacter(FuzzType::ToneCharacter::darkest);
+            break;
+        }
+    }
 
-    case 4: _fuzzModule.setToneCharacter(Fuzz<float>::ToneCharacter::darkest);
-        break;
+    if (applyAll || parameters.oversampling != applied.oversampling || parameters.oversamplingFilter != applied.oversamplingFilter)
+    {
+        fuzzModule.setOversampling(parameters.oversampling, parameters.oversamplingFilter == 0 ? FuzzType::OversamplingFilter::polyphaseIIR
+                                                                                               : FuzzType::OversamplingFilter::firEquiripple);
     }
 
-    _fuzzModule.setDrive(_treeState.getRawParameterValue(inputID)->load());
-    _fuzzModule.setMix(_treeState.getRawParameterValue(mixID)->load());
-    _fuzzModule.setOutput(_treeState.getRawParameterValue(outputID)->load());
+    if (applyAll || parameters.shaper != applied.shaper)
+    {
+        switch (parameters.shaper)
+        {
+        case 0: fuzzModule.setShaperMode(FuzzType::ShaperMode::analytic);
+            break;
+
+        case 1: fuzzModule.setShaperMode(FuzzType::ShaperMode::adaa1stOrder);
+            break;
 
+        case 2: fuzzModule.setShaperMode(FuzzType::ShaperMode::adaa2ndOrder);
+            break;
+
+        case 3: fuzzModule.setShaperMode(FuzzType::ShaperMode::lookupTable);
+            break;
+        }
+    }
+
+    if (applyAll || parameters.drive != applied.drive)
+        fuzzModule.setDrive(parameters.drive);
+
+    if (applyAll || parameters.mix != applied.mix)
+        fuzzModule.setMix(parameters.mix);
+
+    if (applyAll || parameters.output != applied.output)
+        fuzzModule.setOutput(parameters.output);
+
+    if (applyAll || parameters.toneSweep != applied.toneSweep)
+        fuzzModule.setToneSweep(parameters.toneSweep);
+
+    if (applyAll || parameters.toneStage != applied.toneStage)
+        fuzzModule.setStageBypassed(FuzzType::Stage::tone, ! parameters.toneStage);
+
+    if (applyAll || parameters.dcBlocker != applied.dcBlocker)
+        fuzzModule.setStageBypassed(FuzzType::Stage::dcBlocker, ! parameters.dcBlocker);
 }
 
 //==============================================================================
@@ -159,53 +354,176 @@ bool FuzzerAudioProcessor::isMidiEffect() const
 
 double FuzzerAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return isUsingDoublePrecision() ? _fuzzModulesDouble.getUnchecked(0)->getTailLengthSeconds()
+                                    : _fuzzModules.getUnchecked(0)->getTailLengthSeconds();
 }
 
 int FuzzerAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-    // so this should be at least 1, even if you're not really implementing programs.
+    return _presetBank->getNumPresets();
 }
 
 int FuzzerAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return _currentProgram.load();
 }
 
+// Any thread, including the audio thread (MIDI program changes): it only stores the index and raises the parameter flag,
+// with no allocation, locking, file I/O or message posted. The audio thread picks the preset up at its next block,
+// the timer loads its parameters
 void FuzzerAudioProcessor::setCurrentProgram(int index)
 {
+    if (! juce::isPositiveAndBelow(index, _presetBank->getNumPresets()))
+        return;
+
+    _currentProgram.store(index);
+    _programToLoad.store(index, std::memory_order_release);
+    _parametersChanged.store(true, std::memory_order_release);
 }
 
 const juce::String FuzzerAudioProcessor::getProgramName(int index)
 {
-    return {};
+    return _presetBank->getName(index);
 }
 
+// User presets are renamed on disk too, factory presets keep their names
 void FuzzerAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    if (_presetBank->renameUserPreset(index, newName))
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+}
+
+int FuzzerAudioProcessor::saveUserPreset(const juce::String& name)
+{
+    juce::MemoryBlock state;
+    _parameterState.write(state, -1);
+
+    const auto index = _presetBank->addUserPreset(name, state, _parameterState);
+
+    if (index >= 0)
+    {
+        _currentProgram.store(index);
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    }
+
+    return index;
 }
 
 //==============================================================================
 
+namespace
+{
+    //Grows or shrinks the engine list to one engine per channel group, keeping the engines already there
+    template <typename SampleType>
+    void resizeFuzzModules(juce::OwnedArray<Fuzz<SampleType>>& fuzzModules, int numGroups)
+    {
+        while (fuzzModules.size() < numGroups)
+            fuzzModules.add(new Fuzz<SampleType>());
+
+        fuzzModules.removeLast(fuzzModules.size() - numGroups);
+    }
+
+    //One job per channel group: the group's engine on its own subset of the block's channels
+    template <typename SampleType>
+    struct ChannelGroupJobs
+    {
+        juce::OwnedArray<Fuzz<SampleType>>& fuzzModules;
+        juce::dsp::AudioBlock<SampleType> block;
+        int channelsPerGroup;
+
+        static void process(void* context, int group) noexcept
+        {
+            //Denormal flushing is per thread, workers set it for themselves
+            juce::ScopedNoDenormals noDenormals;
+
+            auto& jobs = *static_cast<ChannelGroupJobs*>(context);
+            const auto firstChannel = static_cast<size_t>(group * jobs.channelsPerGroup);
+            const auto numChannels = juce::jmin(static_cast<size_t>(jobs.channelsPerGroup), jobs.block.getNumChannels() - firstChannel);
+
+            auto groupBlock = jobs.block.getSubsetChannelBlock(firstChannel, numChannels);
+            jobs.fuzzModules.getUnchecked(group)->process(juce::dsp::ProcessContextReplacing<SampleType>(groupBlock));
+        }
+    };
+}
+
 // Prepare to Play
 void FuzzerAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    //Initialize spec for dsp modules
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = getTotalNumOutputChannels();
+   #if FUZZER_TRACE_STAGES
+    //The writer reads the engines' rings, it has to stop before they are resized
+    _traceWriter.reset();
+   #endif
+
+    //One engine per group of _channelsPerGroup channels, the last group takes what is left
+    const auto numChannels = juce::jmax(1, getTotalNumOutputChannels());
+    const auto numGroups = (numChannels + _channelsPerGroup - 1) / _channelsPerGroup;
+
+    resizeFuzzModules(_fuzzModules, numGroups);
+    resizeFuzzModules(_fuzzModulesDouble, numGroups);
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        //Initialize spec for dsp modules
+        juce::dsp::ProcessSpec spec;
+        spec.maximumBlockSize = samplesPerBlock;
+        spec.sampleRate = sampleRate;
+        spec.numChannels = static_cast<juce::uint32>(juce::jmin(_channelsPerGroup, numChannels - group * _channelsPerGroup));
+
+        if (isUsingDoublePrecision())
+            _fuzzModulesDouble.getUnchecked(group)->prepare(spec);
+        else
+            _fuzzModules.getUnchecked(group)->prepare(spec);
+    }
 
-    _fuzzModule.prepare(spec);
+    //Workers are only spawned when there is more than one group to share out
+    const auto numWorkers = juce::jmin(numGroups - 1, _maxNumWorkers, juce::SystemStats::getNumCpus() - 1);
 
-    updateParameters(); // Ensure all parameters are updated
+    if (numWorkers <= 0)
+        _workerPool.reset();
+    else if (_workerPool == nullptr || _workerPool->getNumWorkers() != numWorkers)
+        _workerPool = std::make_unique<WorkerPool>(numWorkers);
+
+    // Ensure all parameters are updated (the audio thread is not running here)
+    const auto parameters = readParameters();
+
+    for (auto* fuzzModule : _fuzzModules)
+        applyParameters(*fuzzModule, parameters, true);
+
+    for (auto* fuzzModule : _fuzzModulesDouble)
+        applyParameters(*fuzzModule, parameters, true);
+
+    _appliedParameters = parameters;
+
+    setLatencySamples(getFuzzLatencyInSamples(parameters));
+
+    // Load metering starts over with the new budget
+    _loadMeasurer.reset(sampleRate, samplesPerBlock);
+    _msPerSample = 1000.0 / sampleRate;
+    _peakLoad.store(0.0f);
+    _xrunRiskCount.store(0);
+
+   #if FUZZER_TRACE_STAGES
+    juce::Array<StageTraceRing*> traceRings;
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        traceRings.add(isUsingDoublePrecision() ? &_fuzzModulesDouble.getUnchecked(group)->getTraceRing()
+                                                : &_fuzzModules.getUnchecked(group)->getTraceRing());
+    }
+
+    _traceWriter = std::make_unique<StageTraceWriter>(StageTraceWriter::getDefaultFile(), traceRings);
+   #endif
 }
 
 void FuzzerAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    _workerPool.reset();
+
+   #if FUZZER_TRACE_STAGES
+    _traceWriter.reset();
+   #endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -215,12 +533,11 @@ bool FuzzerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
     juce::ignoreUnused(layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout (mono, stereo, surround, ambisonic or discrete) up to _maxNumChannels,
+    // every channel gets its own filter and shaper state
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (layouts.getMainOutputChannelSet().isDisabled() || numChannels > _maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -234,9 +551,104 @@ bool FuzzerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
 }
 #endif
 
+bool FuzzerAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void FuzzerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    handleProgramChanges(midiMessages);
+    processFuzz(buffer, _fuzzModules);
+
+    registerProcessTime(juce::Time::getHighResolutionTicks() - startTicks, buffer.getNumSamples());
+}
+
+// 64-bit hosts drive the double engine directly, with no conversion to float and back
+void FuzzerAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    handleProgramChanges(midiMessages);
+    processFuzz(buffer, _fuzzModulesDouble);
+
+    registerProcessTime(juce::Time::getHighResolutionTicks() - startTicks, buffer.getNumSamples());
+}
+
+void FuzzerAudioProcessor::registerProcessTime(juce::int64 ticks, int numSamples) noexcept
+{
+    if (numSamples <= 0 || _msPerSample <= 0.0)
+        return;
+
+    const auto milliseconds = juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+
+    _loadMeasurer.registerRenderTime(milliseconds, numSamples);
+
+    // Single writer (this thread), so a plain load and store keep the peak
+    const auto load = static_cast<float>(milliseconds / (numSamples * _msPerSample));
+
+    if (load > _peakLoad.load(std::memory_order_relaxed))
+        _peakLoad.store(load, std::memory_order_relaxed);
+
+    if (load > _xrunRiskThreshold)
+        _xrunRiskCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+float FuzzerAudioProcessor::getCpuLoad() const noexcept
+{
+    return static_cast<float>(_loadMeasurer.getLoadAsProportion());
+}
+
+float FuzzerAudioProcessor::getPeakCpuLoad() const noexcept
+{
+    return _peakLoad.load(std::memory_order_relaxed);
+}
+
+int FuzzerAudioProcessor::getXrunRiskCount() const noexcept
+{
+    return _xrunRiskCount.load(std::memory_order_relaxed);
+}
+
+// MIDI program changes (when the plugin is built with MIDI input) select a preset like a host call does
+void FuzzerAudioProcessor::handleProgramChanges(const juce::MidiBuffer& midiMessages)
+{
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+
+        if (message.isProgramChange())
+            setCurrentProgram(message.getProgramChangeNumber());
+    }
+}
+
+bool FuzzerAudioProcessor::shouldProcessInParallel(int numChannels, int numSamples) const noexcept
+{
+    if (_workerPool == nullptr || ! _appliedParameters.multicore)
+        return false;
+
+    return (numChannels * numSamples) << _appliedParameters.oversampling >= _parallelWorkThreshold;
+}
+
+template <typename SampleType>
+void FuzzerAudioProcessor::processFuzz(juce::AudioBuffer<SampleType>& buffer, juce::OwnedArray<Fuzz<SampleType>>& fuzzModules)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    // Parameter changes land once, at the start of the block (a program change swaps the whole preset in at once,
+    // the engine's ramps smooth the transition). The flag is only exchanged once a plain load has seen it set,
+    // so the usual block costs a single load
+    if (_parametersChanged.load(std::memory_order_relaxed) && _parametersChanged.exchange(false, std::memory_order_acquire))
+    {
+        const auto parameters = readParameters();
+
+        for (auto* fuzzModule : fuzzModules)
+            applyParameters(*fuzzModule, parameters, false);
+
+        _appliedParameters = parameters;
+    }
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -245,9 +657,27 @@ void FuzzerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    juce::dsp::AudioBlock<float> block{ buffer };
+    juce::dsp::AudioBlock<SampleType> block{ buffer };
+
+    if (fuzzModules.size() == 1)
+    {
+        fuzzModules.getUnchecked(0)->process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+        return;
+    }
+
+    //Wide buses: each channel group is an independent job, on the worker pool or one after another
+    ChannelGroupJobs<SampleType> jobs{ fuzzModules, block, _channelsPerGroup };
+    const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), fuzzModules.size() * _channelsPerGroup);
+    const auto numGroups = (numChannels + _channelsPerGroup - 1) / _channelsPerGroup;
+
+    if (shouldProcessInParallel(numChannels, buffer.getNumSamples()))
+    {
+        _workerPool->run(&ChannelGroupJobs<SampleType>::process, &jobs, numGroups);
+        return;
+    }
 
-    _fuzzModule.process(juce::dsp::ProcessContextReplacing<float>(block));
+    for (int group = 0; group < numGroups; ++group)
+        ChannelGroupJobs<SampleType>::process(&jobs, group);
 }
 
 //==============================================================================
@@ -265,15 +695,44 @@ juce::AudioProcessorEditor* FuzzerAudioProcessor::createEditor()
 //==============================================================================
 void FuzzerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+   #if FUZZER_XML_STATE
+    // The readable ValueTree XML, loaded back through the fallback below
+    if (auto xml = _treeState.copyState().createXml())
+        copyXmlToBinary(*xml, destData);
+   #else
+    // A few dozen bytes of plain values and the current program, no ValueTree or XML text per instance
+    _parameterState.write(destData, _currentProgram.load());
+   #endif
 }
 
 void FuzzerAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Binary state first: validated (magic, size, CRC) and written straight into the parameters
+    int program = -1;
+
+    if (! _parameterState.read(data, sizeInBytes, program))
+    {
+        // Fallback: the readable ValueTree XML (FUZZER_XML_STATE builds, hand edited sessions), which has no program
+        // Anything else leaves the parameters untouched
+        const auto xml = getXmlFromBinary(data, sizeInBytes);
+
+        if (xml == nullptr || ! xml->hasTagName(_treeState.state.getType()))
+            return;
+
+        _treeState.replaceState(juce::ValueTree::fromXml(*xml));
+    }
+
+    // The restored values win over a program change still being loaded
+    _programToLoad.store(-1, std::memory_order_release);
+    _parametersChanged.store(true, std::memory_order_release);
+
+    // The program is only selected again, not reloaded: the state already holds the session's values, edits included
+    // A program that isn't in this bank (a user preset from another machine) leaves the selection alone
+    if (juce::isPositiveAndBelow(program, _presetBank->getNumPresets()))
+    {
+        _currentProgram.store(program);
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    }
 }
 
 //==============================================================================
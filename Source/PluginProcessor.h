@@ -3,12 +3,16 @@
 
 #include <JuceHeader.h>
 #include "DSP/Fuzz.h"
+#include "DSP/WorkerPool.h"
 #include "Parameters/Parameters.h"
+#include "Parameters/ParameterSnapshot.h"
+#include "Parameters/ParameterState.h"
+#include "Parameters/PresetBank.h"
 
 //==============================================================================
 /**
 */
-class FuzzerAudioProcessor : public juce::AudioProcessor, juce::AudioProcessorValueTreeState::Listener
+class FuzzerAudioProcessor : public juce::AudioProcessor, juce::AudioProcessorValueTreeState::Listener, juce::Timer
 {
 public:
     //==============================================================================
@@ -24,6 +28,9 @@ public:
 #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -44,6 +51,18 @@ public:
     const juce::String getProgramName(int index) override;
     void changeProgramName(int index, const juce::String& newName) override;
 
+    //CPU load of this instance, as a proportion of the real-time budget of the blocks it processed, any thread
+    float getCpuLoad() const noexcept;
+    float getPeakCpuLoad() const noexcept;
+
+    //Blocks that used more than _xrunRiskThreshold of their budget (overruns included), since prepareToPlay
+    int getXrunRiskCount() const noexcept;
+
+    int getNumFactoryPrograms() const noexcept { return _presetBank->getNumFactoryPresets(); }
+
+    //Saves the current settings as a user preset (file and bank entry), returns its program index or -1
+    int saveUserPreset(const juce::String& name);
+
     //==============================================================================
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
@@ -52,11 +71,102 @@ public:
 
 private:
 
+    //Widest bus accepted, any layout up to this (surround beds, ambisonics up to 7th order) runs in one instance
+    static constexpr int _maxNumChannels = 64;
+
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void parameterChanged(const juce::String& parameterID, float newValue) override;
-    void updateParameters();
 
-    Fuzz<float> _fuzzModule;
+    //Message thread: loads the parameters of a program change, and reports what the audio side changed
+    //(latency, tail length) to the host
+    void timerCallback() override;
+
+    //Reads the cached raw values, no parameter lookups (a program still being loaded gives its preset instead)
+    FuzzParameters readParameters() const noexcept;
+
+    //A preset's snapshot, keeping the current Multicore setting (a machine setting, not part of a sound)
+    FuzzParameters getProgramParameters(int index) const noexcept;
+
+    //Audio thread only (or while it is stopped): pushes the parameters that differ from the last applied ones
+    template <typename SampleType>
+    void applyParameters(Fuzz<SampleType>& fuzzModule, const FuzzParameters& parameters, bool applyAll);
+
+    void handleProgramChanges(const juce::MidiBuffer& midiMessages);
+
+    //Audio thread, once per processBlock call
+    void registerProcessTime(juce::int64 ticks, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processFuzz(juce::AudioBuffer<SampleType>& buffer, juce::OwnedArray<Fuzz<SampleType>>& fuzzModules);
+
+    //Channel groups go to the worker pool only when the block is big enough to repay waking the workers
+    bool shouldProcessInParallel(int numChannels, int numSamples) const noexcept;
+
+    int getFuzzLatencyInSamples(const FuzzParameters& parameters) const noexcept;
+
+    //Raw parameter values, resolved once at construction instead of looked up by ID on every change
+    struct ParameterValues
+    {
+        std::atomic<float>* model = nullptr;
+        std::atomic<float>* tone = nullptr;
+        std::atomic<float>* oversampling = nullptr;
+        std::atomic<float>* oversamplingFilter = nullptr;
+        std::atomic<float>* shaper = nullptr;
+        std::atomic<float>* drive = nullptr;
+        std::atomic<float>* mix = nullptr;
+        std::atomic<float>* output = nullptr;
+        std::atomic<float>* toneSweep = nullptr;
+        std::atomic<float>* toneStage = nullptr;
+        std::atomic<float>* dcBlocker = nullptr;
+        std::atomic<float>* multicore = nullptr;
+    };
+
+    ParameterValues _parameterValues;
+
+    //Session state: the compact binary blob, with the ValueTree XML still accepted when loading (see FUZZER_XML_STATE)
+    ParameterState _parameterState;
+
+    //Programs: a host call or MIDI program change only stores the index, the audio thread swaps the preset's
+    //snapshot in at its next block and the parameters follow from the message thread timer
+    //_programToLoad stays set until the parameters hold the preset, readParameters returns the preset meanwhile
+    juce::SharedResourcePointer<PresetBank> _presetBank;
+    std::atomic<int> _currentProgram{ 0 };
+    std::atomic<int> _programToLoad{ -1 };
+
+    //Parameter changes from any thread only raise a flag (wait-free, no lock and no message posted),
+    //the audio thread takes its snapshot of the raw values at the start of the next block
+    std::atomic<bool> _parametersChanged{ true };
+    FuzzParameters _appliedParameters;
+
+    //Latency and tail changes are reported from the message thread, which polls for them
+    std::atomic<bool> _latencyChanged{ false };
+    double _reportedTailLength = 0.0;
+    static constexpr int _messagePollIntervalMs = 20;
+
+    //One engine per channel group and precision, only the ones matching the host's processing precision are prepared
+    //Mono and stereo are a single group, wider buses are split so the groups can run on the worker pool
+    static constexpr int _channelsPerGroup = 4;
+    juce::OwnedArray<Fuzz<float>> _fuzzModules;
+    juce::OwnedArray<Fuzz<double>> _fuzzModulesDouble;
+
+    //Pre-spawned in prepareToPlay for wide buses, used when Multicore is on
+    static constexpr int _maxNumWorkers = 3;
+    static constexpr int _parallelWorkThreshold = 8192; //Channel samples per block, at the oversampled rate
+    std::unique_ptr<WorkerPool> _workerPool;
+
+    //Load metering: one pair of clock reads around each processBlock call, the smoothed load and overruns are kept
+    //by the measurer, the peak and the xrun-risk count here
+    juce::AudioProcessLoadMeasurer _loadMeasurer;
+    double _msPerSample = 0.0;
+    static constexpr float _xrunRiskThreshold = 0.8f;
+    std::atomic<float> _peakLoad{ 0.0f };
+    std::atomic<int> _xrunRiskCount{ 0 };
+
+   #if FUZZER_TRACE_STAGES
+    //Stage timing trace of the prepared engines, a new file for each prepareToPlay (see DSP/StageTrace.h)
+    //Declared last so it stops before the engines it reads from are destroyed
+    std::unique_ptr<StageTraceWriter> _traceWriter;
+   #endif
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FuzzerAudioProcessor)
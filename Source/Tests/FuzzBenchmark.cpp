@@ -0,0 +1,256 @@
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+
+//Host block size sweep, down to single samples, of the engine and of the whole processBlock call (parameter
+//and program checks, load meter), in nanoseconds per sample. Timings are logged, never asserted
+//Off by default: build with FUZZER_BENCHMARKS=1 and run the "Benchmarks" category from a JUCE test runner,
+//juce::UnitTestRunner().runTestsInCategory("Benchmarks"), in an optimised build
+//The behaviour the tiling must keep (output independent of the host block size, finite at extreme settings) is
+//checked by the "Fuzzer" category, built with JUCE_UNIT_TESTS=1
+#ifndef FUZZER_BENCHMARKS
+ #define FUZZER_BENCHMARKS 0
+#endif
+
+#if FUZZER_BENCHMARKS || JUCE_UNIT_TESTS
+
+namespace
+{
+    constexpr double benchmarkSampleRate = 48000.0;
+    constexpr int benchmarkLength = 1 << 17; //About 2.7 seconds of audio per block size
+
+    //A loud tone on every channel, so silence skipping never kicks in
+    juce::AudioBuffer<float> makeSignal(int numChannels)
+    {
+        juce::AudioBuffer<float> signal(numChannels, benchmarkLength);
+
+        for (int n = 0; n < benchmarkLength; ++n)
+        {
+            const auto sample = 0.3f * std::sin(juce::MathConstants<float>::twoPi * 110.0f * static_cast<float>(n / benchmarkSampleRate));
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                signal.setSample(ch, n, sample);
+        }
+
+        return signal;
+    }
+}
+
+#endif
+
+#if FUZZER_BENCHMARKS
+
+namespace
+{
+    constexpr int blockSizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 8192 };
+
+    double ticksToNanosecondsPerSample(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / benchmarkLength;
+    }
+
+    juce::String formatColumn(double nanosecondsPerSample)
+    {
+        return juce::String(nanosecondsPerSample, 1).paddedLeft(' ', 10);
+    }
+}
+
+
+class FuzzBenchmark : public juce::UnitTest
+{
+public:
+
+    FuzzBenchmark() : juce::UnitTest("Fuzz block size sweep", "Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Engine, ns per sample");
+        logMessage("    block       2ch  2ch os4x      16ch");
+
+        for (auto blockSize : blockSizes)
+        {
+            logMessage(juce::String(blockSize).paddedLeft(' ', 9)
+                + formatColumn(timeEngine(2, 0, blockSize))
+                + formatColumn(timeEngine(2, 2, blockSize))
+                + formatColumn(timeEngine(16, 0, blockSize)));
+        }
+
+        beginTest("Processor, ns per sample");
+        logMessage("    block    stereo");
+
+        for (auto blockSize : blockSizes)
+            logMessage(juce::String(blockSize).paddedLeft(' ', 9) + formatColumn(timeProcessor(blockSize)));
+    }
+
+private:
+
+    static double timeEngine(int numChannels, int oversamplingFactor, int blockSize)
+    {
+        Fuzz<float> fuzz;
+        fuzz.setOversampling(oversamplingFactor, Fuzz<float>::OversamplingFilter::polyphaseIIR);
+
+        juce::dsp::ProcessSpec spec{ benchmarkSampleRate, static_cast<juce::uint32>(blockSize), static_cast<juce::uint32>(numChannels) };
+        fuzz.prepare(spec);
+
+        auto signal = makeSignal(numChannels);
+        const juce::dsp::AudioBlock<float> block{ signal };
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int start = 0; start < benchmarkLength; start += blockSize)
+        {
+            auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(juce::jmin(blockSize, benchmarkLength - start)));
+            fuzz.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        }
+
+        return ticksToNanosecondsPerSample(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    static double timeProcessor(int blockSize)
+    {
+        FuzzerAudioProcessor processor;
+        processor.setPlayConfigDetails(2, 2, benchmarkSampleRate, blockSize);
+        processor.prepareToPlay(benchmarkSampleRate, blockSize);
+
+        auto signal = makeSignal(2);
+        juce::MidiBuffer midiMessages;
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int start = 0; start < benchmarkLength; start += blockSize)
+        {
+            juce::AudioBuffer<float> buffer(signal.getArrayOfWritePointers(), 2, start, juce::jmin(blockSize, benchmarkLength - start));
+            processor.processBlock(buffer, midiMessages);
+        }
+
+        const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+        processor.releaseResources();
+
+        return ticksToNanosecondsPerSample(ticks);
+    }
+};
+
+static FuzzBenchmark fuzzBenchmark;
+
+#endif
+
+#if JUCE_UNIT_TESTS
+
+namespace
+{
+    struct EngineSettings
+    {
+        Fuzz<float>::FuzzModel model;
+        Fuzz<float>::ShaperMode shaperMode;
+        int oversamplingFactor;
+        Fuzz<float>::OversamplingFilter oversamplingFilter;
+        float drive;
+        float output;
+        float toneSweep;
+    };
+
+    //Runs the signal through a fresh engine in host blocks of blockSize samples, in place
+    //The smoothed settings are applied after prepare, as the processor does, so they ramp in from their defaults
+    void renderEngine(juce::AudioBuffer<float>& signal, const EngineSettings& settings, int blockSize)
+    {
+        Fuzz<float> fuzz;
+        fuzz.setFuzzModel(settings.model);
+        fuzz.setShaperMode(settings.shaperMode);
+        fuzz.setOversampling(settings.oversamplingFactor, settings.oversamplingFilter);
+
+        juce::dsp::ProcessSpec spec{ benchmarkSampleRate, static_cast<juce::uint32>(blockSize), static_cast<juce::uint32>(signal.getNumChannels()) };
+        fuzz.prepare(spec);
+
+        fuzz.setDrive(settings.drive);
+        fuzz.setOutput(settings.output);
+        fuzz.setToneSweep(settings.toneSweep);
+
+        const juce::dsp::AudioBlock<float> block{ signal };
+
+        for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+        {
+            auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(juce::jmin(blockSize, signal.getNumSamples() - start)));
+            fuzz.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        }
+    }
+}
+
+
+class FuzzTilingTests : public juce::UnitTest
+{
+public:
+
+    FuzzTilingTests() : juce::UnitTest("Fuzz tiling", "Fuzzer") {}
+
+    void runTest() override
+    {
+        using FuzzType = Fuzz<float>;
+
+        //Drive and output ramp per sample, so their ramps must come out the same too. The tone sweep is left at rest:
+        //a moving sweep updates the filters once per control interval of each tile, so its ramps follow the blocks
+        const EngineSettings settings[] =
+        {
+            { FuzzType::FuzzModel::kHard,  FuzzType::ShaperMode::analytic,     0, FuzzType::OversamplingFilter::polyphaseIIR,  18.0f,  0.0f, 0.0f },
+            { FuzzType::FuzzModel::kRedux, FuzzType::ShaperMode::adaa1stOrder, 1, FuzzType::OversamplingFilter::polyphaseIIR,  12.0f,  6.0f, 0.0f },
+            { FuzzType::FuzzModel::kFat,   FuzzType::ShaperMode::adaa2ndOrder, 2, FuzzType::OversamplingFilter::firEquiripple, 24.0f,  0.0f, 0.0f },
+            { FuzzType::FuzzModel::kHard,  FuzzType::ShaperMode::lookupTable,  1, FuzzType::OversamplingFilter::firEquiripple,  6.0f, -6.0f, 0.0f }
+        };
+
+        beginTest("Output doesn't depend on the host block size");
+        {
+            for (const auto& setting : settings)
+            {
+                auto reference = makeSignal(2);
+                renderEngine(reference, setting, 512);
+
+                //Bit-identical, except that JUCE's polyphase IIR oversampler flushes tiny filter states to zero at the
+                //end of every call (so at each tile boundary), which moves the odd sample by a rounding step
+                const auto tolerance = setting.oversamplingFactor > 0 && setting.oversamplingFilter == FuzzType::OversamplingFilter::polyphaseIIR
+                    ? 1.0e-6f : 0.0f;
+
+                for (auto blockSize : { 37, 1 })
+                {
+                    auto output = makeSignal(2);
+                    renderEngine(output, setting, blockSize);
+
+                    auto maxError = 0.0f;
+
+                    for (int ch = 0; ch < 2; ++ch)
+                        for (int n = 0; n < benchmarkLength; ++n)
+                            maxError = juce::jmax(maxError, std::abs(reference.getSample(ch, n) - output.getSample(ch, n)));
+
+                    expectLessOrEqual(maxError, tolerance, juce::String(blockSize) + "-sample blocks");
+                }
+            }
+        }
+
+        beginTest("Extreme drive and output stay finite");
+        {
+            for (auto model : { FuzzType::FuzzModel::kHard, FuzzType::FuzzModel::kRedux, FuzzType::FuzzModel::kFat })
+            {
+                for (auto shaperMode : { FuzzType::ShaperMode::analytic, FuzzType::ShaperMode::adaa1stOrder, FuzzType::ShaperMode::adaa2ndOrder, FuzzType::ShaperMode::lookupTable })
+                {
+                    //A full-scale square, the worst case for the ADAA difference quotients
+                    juce::AudioBuffer<float> signal(2, benchmarkLength);
+
+                    for (int n = 0; n < benchmarkLength; ++n)
+                        for (int ch = 0; ch < 2; ++ch)
+                            signal.setSample(ch, n, (n / 50) % 2 == 0 ? 1.0f : -1.0f);
+
+                    renderEngine(signal, { model, shaperMode, 2, FuzzType::OversamplingFilter::polyphaseIIR, 24.0f, 20.0f, 1.0f }, 256);
+
+                    auto isFinite = true;
+
+                    for (int ch = 0; ch < 2; ++ch)
+                        for (int n = 0; n < benchmarkLength; ++n)
+                            isFinite = isFinite && std::isfinite(signal.getSample(ch, n));
+
+                    expect(isFinite, "Model " + juce::String(static_cast<int>(model)) + ", shaper " + juce::String(static_cast<int>(shaperMode)));
+                }
+            }
+        }
+    }
+};
+
+static FuzzTilingTests fuzzTilingTests;
+
+#endif
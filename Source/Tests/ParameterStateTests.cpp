@@ -0,0 +1,172 @@
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../Parameters/Parameters.h"
+
+//Binary state format checks: round trips, states written by older and newer schema versions, damaged states
+//Built with JUCE_UNIT_TESTS=1, run the "Fuzzer" category from a JUCE test runner
+#if JUCE_UNIT_TESTS
+
+namespace
+{
+    constexpr int stateMagic = 0x54535a46;
+    constexpr size_t stateHeaderSize = 8;
+    constexpr size_t stateChecksumSize = 4;
+
+    //CRC-32 (IEEE, reflected), bit by bit, independent of the table the state uses
+    juce::uint32 referenceCrc(const juce::uint8* data, size_t numBytes)
+    {
+        juce::uint32 crc = 0xffffffffu;
+
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            crc ^= data[i];
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+        }
+
+        return crc ^ 0xffffffffu;
+    }
+
+    //A state as another schema version would write it: header, values, CRC
+    juce::MemoryBlock makeState(juce::uint16 version, juce::uint16 numParameters, const juce::Array<float>& values,
+                                int magic = stateMagic)
+    {
+        juce::MemoryOutputStream stream;
+        stream.writeInt(magic);
+        stream.writeShort(static_cast<short>(version));
+        stream.writeShort(static_cast<short>(numParameters));
+
+        for (auto value : values)
+            stream.writeFloat(value);
+
+        const auto crc = referenceCrc(static_cast<const juce::uint8*>(stream.getData()), stream.getDataSize());
+        stream.writeInt(static_cast<int>(crc));
+
+        return stream.getMemoryBlock();
+    }
+
+    //The stored values of a state, header and CRC stripped
+    juce::Array<float> getStoredValues(const juce::MemoryBlock& state)
+    {
+        juce::MemoryInputStream stream(state, false);
+        stream.setPosition(static_cast<juce::int64>(stateHeaderSize));
+
+        juce::Array<float> values;
+
+        while (stream.getPosition() < static_cast<juce::int64>(state.getSize() - stateChecksumSize))
+            values.add(stream.readFloat());
+
+        return values;
+    }
+}
+
+
+class ParameterStateTests : public juce::UnitTest
+{
+public:
+
+    ParameterStateTests() : juce::UnitTest("Binary plugin state", "Fuzzer") {}
+
+    void runTest() override
+    {
+        FuzzerAudioProcessor processor;
+        ParameterState state(processor._treeState);
+
+        auto* drive = processor._treeState.getParameter(inputID);
+        auto* model = processor._treeState.getParameter(fuzzModelID);
+
+        const auto driveValue = drive->convertTo0to1(6.0f);
+        const auto modelValue = model->convertTo0to1(2.0f);
+
+        beginTest("Round trip");
+        {
+            drive->setValueNotifyingHost(driveValue);
+            model->setValueNotifyingHost(modelValue);
+
+            juce::MemoryBlock data;
+            state.write(data, 3);
+
+            drive->setValueNotifyingHost(drive->getDefaultValue());
+            model->setValueNotifyingHost(model->getDefaultValue());
+
+            int program = -2;
+            expect(state.read(data.getData(), static_cast<int>(data.getSize()), program));
+            expectEquals(program, 3);
+            expectWithinAbsoluteError(drive->getValue(), driveValue, 1.0e-6f);
+            expectWithinAbsoluteError(model->getValue(), modelValue, 1.0e-6f);
+        }
+
+        beginTest("Version 1 state has no program");
+        {
+            juce::MemoryBlock data;
+            state.write(data, 3);
+
+            auto values = getStoredValues(data);
+            values.removeLast();
+
+            int program = -2;
+            const auto v1 = makeState(1, static_cast<juce::uint16>(values.size()), values);
+            expect(state.read(v1.getData(), static_cast<int>(v1.getSize()), program));
+            expectEquals(program, -1);
+            expectWithinAbsoluteError(drive->getValue(), driveValue, 1.0e-6f);
+        }
+
+        beginTest("A parameter appended by a later version doesn't move the program");
+        {
+            juce::MemoryBlock data;
+            state.write(data, 5);
+
+            auto values = getStoredValues(data);
+            const auto numParameters = values.size() - 1;
+            values.insert(numParameters, 0.75f);
+
+            int program = -2;
+            const auto v3 = makeState(3, static_cast<juce::uint16>(numParameters + 1), values);
+            expect(state.read(v3.getData(), static_cast<int>(v3.getSize()), program));
+            expectEquals(program, 5);
+            expectWithinAbsoluteError(drive->getValue(), driveValue, 1.0e-6f);
+            expectWithinAbsoluteError(model->getValue(), modelValue, 1.0e-6f);
+        }
+
+        beginTest("Damaged states are rejected and leave the parameters alone");
+        {
+            juce::MemoryBlock data;
+            state.write(data, 3);
+
+            //Every damaged copy would set drive back to its default
+            drive->setValueNotifyingHost(drive->getDefaultValue());
+            const auto untouchedDrive = drive->getValue();
+
+            const auto expectRejected = [&](const juce::MemoryBlock& damaged, const juce::String& what)
+            {
+                int program = -2;
+                expect(! state.read(damaged.getData(), static_cast<int>(damaged.getSize()), program), what + " accepted");
+                expectEquals(drive->getValue(), untouchedDrive, what + " changed a parameter");
+            };
+
+            for (size_t size = 0; size < data.getSize(); ++size)
+                expectRejected(juce::MemoryBlock(data.getData(), size), "Truncated to " + juce::String(static_cast<int>(size)) + " bytes");
+
+            for (size_t bit = 0; bit < data.getSize() * 8; ++bit)
+            {
+                auto flipped = data;
+                flipped[bit / 8] = static_cast<char>(flipped[bit / 8] ^ (1 << (bit % 8)));
+                expectRejected(flipped, "Bit " + juce::String(static_cast<int>(bit)) + " flipped");
+            }
+
+            //A correct CRC over the wrong magic still isn't a state
+            const auto values = getStoredValues(data);
+            expectRejected(makeState(2, static_cast<juce::uint16>(values.size() - 1), values, 0x54535a47), "Wrong magic");
+
+            expectRejected(juce::MemoryBlock(), "Empty data");
+
+            int program = -2;
+            expect(! state.read(nullptr, 0, program), "Null data accepted");
+        }
+    }
+};
+
+static ParameterStateTests parameterStateTests;
+
+#endif
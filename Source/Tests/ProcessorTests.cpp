@@ -0,0 +1,185 @@
+#include <JuceHeader.h>
+#include <thread>
+#include "../PluginProcessor.h"
+#include "../Parameters/Parameters.h"
+
+//Whole-processor behaviour checks, driving processBlock the way a host does
+//Built with JUCE_UNIT_TESTS=1, run the "Fuzzer" category from a JUCE test runner
+#if JUCE_UNIT_TESTS
+
+namespace
+{
+    constexpr double testSampleRate = 48000.0;
+    constexpr int testBlockSize = 256;
+    constexpr int testNumBlocks = 16;
+
+    void fillBlock(juce::AudioBuffer<float>& buffer, int blockIndex)
+    {
+        for (int n = 0; n < buffer.getNumSamples(); ++n)
+        {
+            const auto time = static_cast<float>((blockIndex * buffer.getNumSamples() + n) / testSampleRate);
+            const auto sample = 0.3f * std::sin(juce::MathConstants<float>::twoPi * 110.0f * time);
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.setSample(ch, n, sample);
+        }
+    }
+
+    //Stereo output of a program change at the first block, with Multicore toggled at block touchBlock (-1 for never)
+    //The message thread never runs here, so the program's parameters are never loaded: the whole run is inside the
+    //window between the audio thread taking the program and the timer loading it
+    juce::AudioBuffer<float> renderProgramChange(int program, int touchBlock)
+    {
+        FuzzerAudioProcessor processor;
+        processor.setPlayConfigDetails(2, 2, testSampleRate, testBlockSize);
+        processor.prepareToPlay(testSampleRate, testBlockSize);
+
+        auto* multicore = processor._treeState.getParameter(multicoreID);
+
+        juce::AudioBuffer<float> output(2, testBlockSize * testNumBlocks);
+        juce::AudioBuffer<float> buffer(2, testBlockSize);
+        juce::MidiBuffer midiMessages;
+
+        processor.setCurrentProgram(program);
+
+        for (int block = 0; block < testNumBlocks; ++block)
+        {
+            if (block == touchBlock)
+                multicore->setValueNotifyingHost(1.0f - multicore->getValue());
+
+            fillBlock(buffer, block);
+            processor.processBlock(buffer, midiMessages);
+
+            for (int ch = 0; ch < 2; ++ch)
+                output.copyFrom(ch, block * testBlockSize, buffer, ch, 0, testBlockSize);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    //First sample index at which any channel differs, -1 when the buffers are identical
+    int findFirstDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        for (int n = 0; n < a.getNumSamples(); ++n)
+            for (int ch = 0; ch < a.getNumChannels(); ++ch)
+                if (a.getSample(ch, n) != b.getSample(ch, n))
+                    return n;
+
+        return -1;
+    }
+}
+
+
+class ProcessorTests : public juce::UnitTest
+{
+public:
+
+    ProcessorTests() : juce::UnitTest("Processor", "Fuzzer") {}
+
+    void runTest() override
+    {
+        beginTest("A parameter flag raised before the program is loaded keeps the program");
+        {
+            //Hard Drive: far enough from Init that a step back to the old values shows in the output
+            const auto program = 2;
+            const auto reference = renderProgramChange(program, -1);
+            const auto touched = renderProgramChange(program, 4);
+
+            expectEquals(findFirstDifference(reference, touched), -1);
+        }
+
+        beginTest("The last parameter change from another thread always lands");
+        {
+            constexpr float finalDrive = 14.0f;
+            constexpr float finalMix = 0.6f;
+
+            FuzzerAudioProcessor processor;
+            processor.setPlayConfigDetails(2, 2, testSampleRate, testBlockSize);
+            processor.prepareToPlay(testSampleRate, testBlockSize);
+
+            auto* drive = processor._treeState.getParameter(inputID);
+            auto* mix = processor._treeState.getParameter(mixID);
+
+            //Changes race the blocks, the last ones are the final values
+            std::atomic<bool> isWriting{ true };
+
+            std::thread writer([&]
+            {
+                juce::Random random(1);
+
+                for (int i = 0; i < 200000; ++i)
+                {
+                    drive->setValueNotifyingHost(random.nextFloat());
+                    mix->setValueNotifyingHost(random.nextFloat());
+                }
+
+                drive->setValueNotifyingHost(drive->convertTo0to1(finalDrive));
+                mix->setValueNotifyingHost(mix->convertTo0to1(finalMix));
+                isWriting.store(false);
+            });
+
+            juce::AudioBuffer<float> buffer(2, testBlockSize);
+            juce::MidiBuffer midiMessages;
+            int block = 0;
+
+            while (isWriting.load())
+            {
+                fillBlock(buffer, block++);
+                processor.processBlock(buffer, midiMessages);
+            }
+
+            writer.join();
+
+            //The same settings from the start, both run on until the ramps and filters have settled
+            FuzzerAudioProcessor reference;
+            reference._treeState.getParameter(inputID)->setValueNotifyingHost(drive->convertTo0to1(finalDrive));
+            reference._treeState.getParameter(mixID)->setValueNotifyingHost(mix->convertTo0to1(finalMix));
+            reference.setPlayConfigDetails(2, 2, testSampleRate, testBlockSize);
+            reference.prepareToPlay(testSampleRate, testBlockSize);
+
+            juce::AudioBuffer<float> referenceBuffer(2, testBlockSize);
+            const auto lastBlock = block + static_cast<int>(testSampleRate) / testBlockSize;
+
+            for (int referenceBlock = 0; referenceBlock <= lastBlock; ++referenceBlock)
+            {
+                fillBlock(referenceBuffer, referenceBlock);
+                reference.processBlock(referenceBuffer, midiMessages);
+            }
+
+            for (; block <= lastBlock; ++block)
+            {
+                fillBlock(buffer, block);
+                processor.processBlock(buffer, midiMessages);
+            }
+
+            auto maxError = 0.0f;
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int n = 0; n < testBlockSize; ++n)
+                    maxError = juce::jmax(maxError, std::abs(buffer.getSample(ch, n) - referenceBuffer.getSample(ch, n)));
+
+            expectLessThan(maxError, 1.0e-4f);
+        }
+
+        beginTest("The ValueTree XML state is accepted");
+        {
+            FuzzerAudioProcessor source;
+            auto* sourceDrive = source._treeState.getParameter(inputID);
+            sourceDrive->setValueNotifyingHost(sourceDrive->convertTo0to1(12.0f));
+
+            juce::MemoryBlock data;
+            const auto xml = source._treeState.copyState().createXml();
+            juce::AudioProcessor::copyXmlToBinary(*xml, data);
+
+            FuzzerAudioProcessor processor;
+            processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+
+            expectWithinAbsoluteError(processor._treeState.getParameter(inputID)->getValue(), sourceDrive->getValue(), 1.0e-6f);
+        }
+    }
+};
+
+static ProcessorTests processorTests;
+
+#endif
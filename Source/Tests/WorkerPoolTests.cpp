@@ -0,0 +1,82 @@
+#include <JuceHeader.h>
+#include "../DSP/WorkerPool.h"
+
+//Worker pool checks: every job of every batch runs exactly once, and run() only returns after all of them
+//Built with JUCE_UNIT_TESTS=1, run the "Fuzzer" category from a JUCE test runner
+#if JUCE_UNIT_TESTS
+
+namespace
+{
+    constexpr int maxNumJobs = 16;
+
+    struct JobCounts
+    {
+        std::array<std::atomic<int>, maxNumJobs> runs{};
+        std::atomic<int> numOutOfRange{ 0 };
+
+        void reset() noexcept
+        {
+            for (auto& count : runs)
+                count.store(0);
+
+            numOutOfRange.store(0);
+        }
+    };
+
+    void countJob(void* context, int jobIndex)
+    {
+        auto& counts = *static_cast<JobCounts*>(context);
+
+        if (juce::isPositiveAndBelow(jobIndex, maxNumJobs))
+            counts.runs[static_cast<size_t>(jobIndex)].fetch_add(1);
+        else
+            counts.numOutOfRange.fetch_add(1);
+    }
+}
+
+
+class WorkerPoolTests : public juce::UnitTest
+{
+public:
+
+    WorkerPoolTests() : juce::UnitTest("Worker pool", "Fuzzer") {}
+
+    void runTest() override
+    {
+        for (int numWorkers = 1; numWorkers <= 3; ++numWorkers)
+        {
+            beginTest("Every job runs exactly once, " + juce::String(numWorkers) + " workers");
+
+            WorkerPool pool(numWorkers);
+            JobCounts counts;
+            auto random = getRandom();
+            int numFailedBatches = 0;
+
+            //Batch sizes vary, and some batches come back to back while workers still spin, others after they park
+            for (int batch = 0; batch < 20000; ++batch)
+            {
+                const auto numJobs = 1 + random.nextInt(maxNumJobs);
+                counts.reset();
+
+                pool.run(&countJob, &counts, numJobs);
+
+                auto isBatchExact = counts.numOutOfRange.load() == 0;
+
+                for (int job = 0; job < maxNumJobs; ++job)
+                    isBatchExact = isBatchExact && counts.runs[static_cast<size_t>(job)].load() == (job < numJobs ? 1 : 0);
+
+                if (! isBatchExact)
+                    ++numFailedBatches;
+
+                if (batch % 1000 == 999)
+                    juce::Thread::sleep(2);
+            }
+
+            expectEquals(numFailedBatches, 0);
+        }
+    }
+};
+
+static WorkerPoolTests workerPoolTests;
+
+#endif